@@ -0,0 +1,102 @@
+/* benchmarks are built around scout.c itself, with its main out of the way */
+#define main scoutMain
+#include "../scout.c"
+#undef main
+
+#include <errno.h>
+#include <sched.h>
+
+int benchCores(int);
+int benchInit(void);
+double benchNow(void);
+size_t benchResident(void);
+int benchTree(char *, int);
+int benchUntree(char *, int);
+
+int benchCores(int count)
+{
+	int i;
+	cpu_set_t set;
+
+	/* threads started later inherit the mask */
+	CPU_ZERO(&set);
+	for (i = 0; i < count && i < CPU_SETSIZE; i++)
+		CPU_SET(i, &set);
+
+	return sched_setaffinity(0, sizeof(cpu_set_t), &set) == OK ? OK : ERR;
+}
+
+int benchInit(void)
+{
+	/* only what the listing code reads, no curses and no loader */
+	scout = utilsCalloc(1, sizeof(struct mainstruct));
+	scout->loadpipe[0] = scout->loadpipe[1] = ERR;
+	scout->watchfd = ERR;
+
+	return OK;
+}
+
+double benchNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+size_t benchResident(void)
+{
+	FILE *fp;
+	unsigned long size, resident = 0;
+
+	if ((fp = fopen("/proc/self/statm", "r")) == NULL)
+		return 0;
+
+	if (fscanf(fp, "%lu %lu", &size, &resident) != 2)
+		resident = 0;
+	fclose(fp);
+
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+int benchTree(char *path, int count)
+{
+	int i, fd, dirfd;
+	char name[32];
+
+	/* empty files are enough, the cost is in the entries */
+	if (mkdir(path, 0755) != OK && errno != EEXIST)
+		return ERR;
+
+	if ((dirfd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+		return ERR;
+
+	for (i = 0; i < count; i++)
+	{
+		snprintf(name, sizeof(name), "file%d.%c", i, 'a' + i % 26);
+		if ((fd = openat(dirfd, name, O_WRONLY | O_CREAT | O_CLOEXEC, 0644)) < 0)
+			break;
+		close(fd);
+	}
+	close(dirfd);
+
+	return i == count ? OK : ERR;
+}
+
+int benchUntree(char *path, int count)
+{
+	int i, dirfd;
+	char name[32];
+
+	if ((dirfd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+		return ERR;
+
+	for (i = 0; i < count; i++)
+	{
+		snprintf(name, sizeof(name), "file%d.%c", i, 'a' + i % 26);
+		unlinkat(dirfd, name, 0);
+	}
+	close(dirfd);
+
+	return rmdir(path);
+}
@@ -0,0 +1,67 @@
+/*
+ * Leaves and comes back to 100k directories through the state cache,
+ * most of them sharing their last path component. Usage: cache [count]
+ */
+#include "bench.h"
+
+static char *leaves[] = {"src", "lib", "bin", "doc", "test"};
+static char *names[] = {"a", "b", "lib", "src", "z"};
+
+int main(int argc, char *argv[])
+{
+	int i, j, pass, missed;
+	double start, took[3];
+	char path[PATH_MAX];
+	int count = argc > 1 ? atoi(argv[1]) : 100000;
+	SDIR *dir;
+
+	benchInit();
+	dir = utilsCalloc(1, sizeof(SDIR));
+	for (i = 0; i < (int) ARRLENGTH(names); i++)
+		scoutAddEntry(dir, names[i]);
+	dir->path = path;
+
+	/* leaving one stores where the selection was and what was marked */
+	start = benchNow();
+	for (i = 0; i < count; i++)
+	{
+		snprintf(path, sizeof(path), "/bench/%d/%d/%s", i % 997, i, leaves[i % ARRLENGTH(leaves)]);
+		dir->selentry = 1 + i % (dir->entrycount - 1);
+		for (j = 0; j < dir->entrycount; j++)
+			dir->entries[j].flags = j == i % dir->entrycount ? ISMRK : 0;
+		scoutCacheDir(dir);
+	}
+	took[0] = benchNow() - start;
+
+	/* coming back finds it again, twice over to see the table settled */
+	for (pass = 1, missed = 0; pass < 3; pass++)
+	{
+		start = benchNow();
+		for (i = 0; i < count; i++)
+		{
+			snprintf(path, sizeof(path), "/bench/%d/%d/%s", i % 997, i, leaves[i % ARRLENGTH(leaves)]);
+			dir->selentry = 0;
+			for (j = 0; j < dir->entrycount; j++)
+				dir->entries[j].flags = 0;
+
+			if (scoutCacheSearch(dir) != OK || dir->selentry != 1 + i % (dir->entrycount - 1)
+			|| !(dir->entries[i % dir->entrycount].flags & ISMRK))
+				missed++;
+		}
+		took[pass] = benchNow() - start;
+	}
+
+	printf("%10s %10s %10s %10s %10s %12s %8s\n", "dirs", "leave ns", "back ns", "again ns", "slots", "path bytes", "missed");
+	printf("%10d %10.0f %10.0f %10.0f %10u %12zu %8d\n", count, took[0] / count * 1e9, took[1] / count * 1e9,
+		took[2] / count * 1e9, scout->cachemask + 1, scout->cachepaths.total, missed);
+
+	dir->path = NULL;
+	scoutFreeDir(&dir);
+	for (i = 0; i <= (int) scout->cachemask; i++)
+		if (scout->cache[i].path != NULL)
+			scoutClipBoard(&scout->cache[i].content, NULL, NULL);
+	utilsFree(scout->cache);
+	utilsArenaFree(&scout->cachepaths);
+
+	return missed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
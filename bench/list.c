@@ -0,0 +1,66 @@
+/*
+ * Reads directories of 10k to 1M entries with scoutReadDir, the way a
+ * pane is loaded, on 1, 2, 4 and up to all cores. Usage: list [dir] [max]
+ */
+#include "bench.h"
+
+#define RUNS 3
+
+int main(int argc, char *argv[])
+{
+	int i, cores, count, ncpu;
+	double start, best, took;
+	char path[PATH_MAX];
+	char *base = argc > 1 ? argv[1] : "/tmp";
+	int max = argc > 2 ? atoi(argv[2]) : 1000000;
+	SDIR *dir;
+
+	benchInit();
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	printf("%10s %6s %10s %14s\n", "entries", "cores", "seconds", "entries/s");
+
+	for (count = 10000; count <= max; count *= 10)
+	{
+		snprintf(path, sizeof(path), "%s/scoutbench.%d", base, count);
+		if (benchTree(path, count) != OK)
+		{
+			fprintf(stderr, "list: cannot fill %s\n", path);
+			benchUntree(path, count);
+			return EXIT_FAILURE;
+		}
+
+		/* cores double until all are in, the last step takes whatever is left */
+		for (cores = 1; ; cores = cores * 2 < ncpu ? cores * 2 : ncpu)
+		{
+			benchCores(cores);
+
+			/* the best of a few, the first one warms the inode cache */
+			for (best = 0, i = 0; i < RUNS; i++)
+			{
+				dir = utilsCalloc(1, sizeof(SDIR));
+				dir->path = utilsMalloc(sizeof(char *) * (strlen(path) + 1));
+				strcpy(dir->path, path);
+
+				start = benchNow();
+				scoutReadDir(dir, 0);
+				took = benchNow() - start;
+
+				if (dir->entrycount != count)
+					fprintf(stderr, "list: read %d of %d entries\n", dir->entrycount, count);
+				scoutFreeDir(&dir);
+
+				if (i == 0 || took < best)
+					best = took;
+			}
+			printf("%10d %6d %10.4f %14.0f\n", count, cores, best, count / best);
+
+			if (cores == ncpu)
+				break;
+		}
+
+		benchCores(ncpu);
+		benchUntree(path, count);
+	}
+
+	return EXIT_SUCCESS;
+}
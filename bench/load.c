@@ -0,0 +1,64 @@
+/*
+ * Loads and frees directories of 1M and 5M entries, timing both and
+ * telling the memory the listing holds. Usage: load [dir] [count ...]
+ */
+#include "bench.h"
+
+#define RUNS 3
+
+int main(int argc, char *argv[])
+{
+	int i, j, count;
+	size_t held, before, after;
+	double start, load, release;
+	char path[PATH_MAX];
+	char *base = argc > 1 ? argv[1] : "/tmp";
+	int counts[] = {1000000, 5000000};
+	SDIR *dir;
+
+	benchInit();
+	printf("%10s %10s %10s %12s %10s %12s\n", "entries", "load s", "free s", "held bytes", "per entry", "resident");
+
+	for (j = 0; j < (argc > 2 ? argc - 2 : (int) ARRLENGTH(counts)); j++)
+	{
+		count = argc > 2 ? atoi(argv[j + 2]) : counts[j];
+		snprintf(path, sizeof(path), "%s/scoutbench.%d", base, count);
+		if (benchTree(path, count) != OK)
+		{
+			fprintf(stderr, "load: cannot fill %s\n", path);
+			benchUntree(path, count);
+			return EXIT_FAILURE;
+		}
+
+		for (i = 0; i < RUNS; i++)
+		{
+			dir = utilsCalloc(1, sizeof(SDIR));
+			dir->path = utilsMalloc(sizeof(char *) * (strlen(path) + 1));
+			strcpy(dir->path, path);
+
+			before = benchResident();
+			start = benchNow();
+			scoutReadDir(dir, 0);
+			load = benchNow() - start;
+			after = benchResident();
+
+			/* everything the listing owns, its strings included */
+			held = sizeof(SDIR) + sizeof(ENTR) * dir->entrycap + dir->namecap + dir->arena.total;
+			if (dir->index != NULL)
+				held += sizeof(int) * (dir->indexmask + 1);
+
+			if (dir->entrycount != count)
+				fprintf(stderr, "load: read %d of %d entries\n", dir->entrycount, count);
+
+			start = benchNow();
+			scoutFreeDir(&dir);
+			release = benchNow() - start;
+
+			printf("%10d %10.4f %10.4f %12zu %10.1f %12zu\n", count, load, release, held, (double) held / count, after - before);
+		}
+
+		benchUntree(path, count);
+	}
+
+	return EXIT_SUCCESS;
+}
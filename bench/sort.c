@@ -0,0 +1,85 @@
+/*
+ * Sorts generated names by comparing them with utilsNameCMP, then by
+ * their precomputed keys the way listings are sorted, and checks both
+ * give the same order. Usage: sort [count]
+ */
+#include "bench.h"
+
+int benchNameCMP(const void *, const void *);
+
+/* bytes >= 0x80 too, utf-8 and latin-1 alike, and the 0xff tolower folds to EOF */
+static char *prefixes[] = {"file", "File", "IMG_", "img", "report-", "Track ", "a", "B", "v", "", "x86_64-", "Zeta",
+	"\xc3\xa9t\xc3\xa9", "\xc3\x89T\xc3\x89", "caf\xe9", "\xff", "\xe6\x97\xa5\xe8\xa8\x98"};
+static char *suffixes[] = {".txt", ".JPG", ".tar.gz", "", "_v2", " (copy)", ".c", ".10", "b", ".mp3", "\xe2\x80\x94" "draft", "\xff"};
+
+int benchNameCMP(const void *A, const void *B)
+{
+	return utilsNameCMP(*(char **) A, *(char **) B);
+}
+
+int main(int argc, char *argv[])
+{
+	int i, mismatch;
+	unsigned int seed = 1;
+	double start, keys, byname, bykey, pooled;
+	char name[NAME_MAX + 1];
+	unsigned char key[KEYSIZE(NAME_MAX)];
+	int count = argc > 1 ? atoi(argv[1]) : 1000000;
+	char **names;
+	ENTR *entries;
+	SDIR *dir;
+
+	benchInit();
+	dir = utilsCalloc(1, sizeof(SDIR));
+	names = utilsMalloc(sizeof(char *) * count);
+
+	/* digit runs of all lengths, mixed case and zero padding, the same every run */
+	for (i = 0; i < count; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		snprintf(name, sizeof(name), seed & 0x100 ? "%s%0*u%s" : "%s%*u%s",
+			prefixes[(seed >> 16) % ARRLENGTH(prefixes)], (int) (seed >> 9) % 6,
+			(seed >> 3) % 100000, suffixes[(seed >> 24) % ARRLENGTH(suffixes)]);
+		names[i] = utilsMalloc(strlen(name) + 1);
+		strcpy(names[i], name);
+	}
+
+	start = benchNow();
+	for (i = 0; i < count; i++)
+		utilsNameKey(names[i], key);
+	keys = benchNow() - start;
+
+	for (i = 0; i < count; i++)
+		scoutAddEntry(dir, names[i]);
+	entries = utilsMalloc(sizeof(ENTR) * count);
+
+	start = benchNow();
+	qsort(names, count, sizeof(char *), benchNameCMP);
+	byname = benchNow() - start;
+
+	/* one thread, so only the compare differs */
+	memcpy(entries, dir->entries, sizeof(ENTR) * count);
+	sortdir = dir;
+	start = benchNow();
+	qsort(entries, count, sizeof(ENTR), scoutCompareEntries);
+	bykey = benchNow() - start;
+
+	start = benchNow();
+	scoutSortEntries(dir, dir->entries, count);
+	pooled = benchNow() - start;
+
+	for (i = mismatch = 0; i < count; i++)
+		if (strcmp(ENAME(dir, &entries[i]), names[i]) != OK || strcmp(ENAME(dir, &dir->entries[i]), names[i]) != OK)
+			mismatch++;
+
+	printf("%10s %10s %12s %10s %10s %8s %10s\n", "names", "keys s", "utilsNameCMP", "key s", "pooled s", "speedup", "mismatch");
+	printf("%10d %10.4f %12.4f %10.4f %10.4f %7.1fx %10d\n", count, keys, byname, bykey, pooled, byname / bykey, mismatch);
+
+	for (i = 0; i < count; i++)
+		utilsFree(names[i]);
+	utilsFree(names);
+	utilsFree(entries);
+	scoutFreeDir(&dir);
+
+	return mismatch ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -5,10 +5,37 @@ static const char *extArchive[] = {"zip", "rar", "7z"};
 
 static const int enablelog  = 1;
 static const char *logfile  = "-log";
+static const int logredraw  = 0;
+
+static const int dentbufsize = 1 << 20;
+static const int statthreads = 8;
+static const int statthreshold = 1024;
+static const int sortthreads = 8;
+static const int sortthreshold = 65536;
+static const int filterthreads = 8;
+static const int filterthreshold = 65536;
+static const int topcount = 50;
+static const int cachebudget = 128 << 20;
+static const int countcache = 65536;
+static const int livewatch = 1;
+static const int useuring = 1;
+static const int enablestream = 1;
+static const int streambatch = 512;
+static const int asyncpreview = 1;
+static const int prefetchrows = 3;
+static const int prefetchsize = 1 << 20;
+static const int duthreads = 8;
+static const char *dufile = ".scout-du";
+static const int ducache = 262144;
+static const int findthreads = 8;
+static const char *findignore[] = {".git", "node_modules", ".cache"};
 
 static const char *errorDirEmpty  = "EMPTY";
 static const char *errorNoAccess  = "ACCESS DENIED";
 static const char *errorSymBroken = "UNRESOLVABLE SYMLINK";
+static const char *infoLoading    = "LOADING";
+static const char *infoCounting   = "...";
+static const char *infoSearching  = "SEARCHING";
 
 static const int nColors[][3] = {
 	{CP_DEFAULT, COLOR_DEFAULT, COLOR_DEFAULT},
@@ -16,7 +16,7 @@ MANPREFIX = ${PREFIX}/share/man
 
 # includes and libs
 INCS = -I${FREETYPEINC}
-LIBS = ${FREETYPELIBS} -lncurses ${KVMLIB}
+LIBS = ${FREETYPELIBS} -lncurses -lpthread ${KVMLIB}
 
 # flags
 CPPFLAGS = -D_DEFAULT_SOURCE -D_GNU_SOURCE -D_POSIX_C_SOURCE=200809L -DVERSION=\"${VERSION}\"
@@ -1,19 +1,33 @@
+#include <sys/inotify.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <ncurses.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <fnmatch.h>
+#include <regex.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <dirent.h>
+#include <limits.h>
 #include <signal.h>
 #include <stdio.h>
 #include <time.h>
+#include <errno.h>
 #include <pwd.h>
+#include <grp.h>
+#include <poll.h>
+#include <pthread.h>
 #include "utils.h"
+#include "uring.h"
 
 /* enums */
 enum {LOAD, RELOAD};
 enum {PREV, CURR, NEXT};
 enum {TOP, BOT, UP, DOWN, LEFT, RIGHT};
+enum {ISMRK = 1, ISSYM = 2, ISTGD = 4, NOACC = 8, ISDRT = 16, ISCNT = 32, ISDU = 64};
+enum {BYNAME, BYSIZE, BYTIME, BYEXT, BYTYPE};
 enum
 {
 	/* color pairings for file types */
@@ -40,29 +54,106 @@ enum
 	CP_FOOTERLINK,
 };
 
+/* macros */
+#define LSIZE 256
+#define PSIZE 16
+#define DSIZE 64
+#define SIZESTR 16
+#define DUMAGIC "scoutdu4"
+#define DUORDER 0x01020304
+#define WATCHMASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_MODIFY | IN_ONLYDIR | IN_EXCL_UNLINK)
+#define EKEY(DIR, ENTRY) ((unsigned char *) (DIR)->names + (ENTRY)->name)
+#define ENAME(DIR, ENTRY) ((DIR)->names + (ENTRY)->name + (ENTRY)->keylen)
+#define EXTLEN(DIR, ENTRY) (EKEY(DIR, ENTRY)[-2] << 8 | EKEY(DIR, ENTRY)[-1])
+#define EEXT(DIR, ENTRY) (EKEY(DIR, ENTRY) - 2 - EXTLEN(DIR, ENTRY))
+#define WALKER(RUN, I) ((WALK *) ((RUN)->walkers + (size_t) (I) * (RUN)->size))
+#define STALE(DIR) ((DIR)->loading && (DIR)->loading != __atomic_load_n(&scout->loadgen, __ATOMIC_RELAXED))
+
 /* structs */
 typedef struct entr
 {
-	int type;
-	int isatu; /* is accessible to user */
-	int ismrk; /* is selected */
-	int issym; /* is symlink */
-	int istgd; /* is tagged */
-	char *name;
-	char *size;
-	char *perms;
-	char *users;
-	char *dates;
-	char *lpath;
+	unsigned int name; /* offset of sort key and name in the name blob */
+	unsigned short keylen;
+	unsigned char type;
+	unsigned char flags; /* ISMRK, ISSYM, ISTGD, NOACC, ISDRT, ISCNT, ISDU */
+	mode_t mode; /* of the symlink target if resolvable */
+	uid_t uid;
+	gid_t gid;
+	unsigned short linekey; /* width and mark state of line, 0 once the entry changes */
+	unsigned short linecap;
+	off_t size;
+	time_t mtime;
+	char *sizestr;
+	char *line; /* as last printed, in the arena */
+	char *link; /* symlink target as read at load, in the arena */
 } ENTR;
 
+typedef struct info
+{
+	char perms[12];
+	char users[66]; /* owner and group */
+	char dates[18];
+	char *lpath; /* NULL for broken symlinks */
+} INFO;
+
+typedef struct sjob
+{
+	int dirfd;
+	int first;
+	int last;
+	char *names;
+	ENTR *entries;
+} SJOB;
+
+typedef struct mjob
+{
+	int first;
+	int middle;
+	int last;
+	ENTR *src;
+	ENTR *dst; /* NULL sorts src in place */
+	struct sdir *dir; /* the context, sortdir is per thread */
+} MJOB;
+
+typedef struct fent
+{
+	unsigned int pos; /* of the lowercased name in the filter blob */
+	unsigned int mask; /* see utilsFuzzyMask */
+	unsigned int rank; /* place in the full listing */
+	int score; /* against the current query, -1 for no match */
+} FENT;
+
+typedef struct fjob
+{
+	int first;
+	int last;
+} FJOB;
+
 typedef struct sdir
 {	
 	char *path;
 	int selentry;
 	int firstentry;
 	int entrycount;
-	ENTR **entries;
+	int entrycap;
+	int entrytotal; /* all entries, while only the top ones are shown */
+	int partial; /* reading was interrupted */
+	unsigned int loading; /* request of the background read filling it */
+	int sortmode; /* the order the entries are in, set before they are read */
+	int sortrev;
+	int *index; /* name hash to entry, built on first lookup */
+	unsigned int indexmask;
+	dev_t dev;
+	ino_t ino;
+	struct timespec mtime; /* as of the read, to tell if it is stale */
+	struct timespec ctime;
+	ENTR *entries;
+	char *names; /* each entry's extension key and its length, sort key and name */
+	unsigned int namesize;
+	unsigned int namecap;
+	unsigned int namedead; /* left behind by entries that went away */
+	ARNA arena; /* strings formatted for display */
+	char *sizefree; /* size strings given back, each starts with a pointer to the next */
 } SDIR;
 
 typedef struct clpb
@@ -76,39 +167,272 @@ typedef struct clpb
 
 typedef struct cach
 {
-	CLPB *content;
-	struct cach *next;
+	char *path; /* interned in the cache arena, NULL for a free slot */
+	unsigned int hash;
+	CLPB content;
 } CACH;
 
+typedef struct cjob
+{
+	char *path; /* of the directory holding the one counted */
+	char *name;
+	int count;
+	struct cjob *next;
+} CJOB;
+
+typedef struct idnm
+{
+	unsigned int id;
+	unsigned int kind; /* 1 for a user, 2 for a group, so no key is all zero */
+	unsigned char ready; /* looked up by the loader, name holds the result */
+	char name[33];
+} IDNM;
+
+typedef struct datc
+{
+	time_t minute;
+	char str[18]; /* empty for a free slot */
+} DATC;
+
+typedef struct cntc
+{
+	dev_t dev;
+	ino_t ino; /* 0 for a free slot */
+	struct timespec mtime;
+	int count;
+	unsigned long stamp; /* last use, the oldest go once the table is full */
+} CNTC;
+
+typedef struct ducc
+{
+	dev_t dev;
+	ino_t ino; /* 0 for a free slot */
+	struct timespec mtime;
+	off_t size; /* of what sits right in it, subdirectories are walked anyway */
+	int links; /* hardlinked files in it, left out of size and counted on every walk */
+	time_t used; /* start of the last session that walked it, the oldest are dropped on save */
+} DUCC;
+
+typedef struct witm
+{
+	char *path;
+	int root; /* which of the run's roots it lies under */
+} WITM;
+
+typedef struct walk
+{
+	pthread_mutex_t lock;
+	WITM *items; /* pushed and popped at last, stolen at first */
+	int first;
+	int last;
+	int cap;
+	int index; /* among the run's walkers */
+	char *buf;
+	struct wrun *run;
+} WALK;
+
+typedef struct wrun
+{
+	char *walkers; /* each starts with a WALK */
+	size_t size;
+	int count;
+	int outstanding; /* pushed and not walked yet */
+	int queued; /* pushed and not taken yet */
+	int waiting; /* walkers asleep on cond */
+	int cancel;
+	pthread_mutex_t lock;
+	pthread_cond_t cond; /* a push, the end of the walk or a cancel wakes them */
+	int (*walk)(WALK *, WITM *); /* one directory, pushing the ones below it */
+} WRUN;
+
+typedef struct drun
+{
+	WRUN walk; /* first, so the walkers get back to the run through it */
+	char *path;
+	dev_t dev; /* the walk stays on this filesystem */
+	char **names;
+	off_t *sizes;
+	int *pending; /* directories of each root not walked yet */
+	int *applied;
+	int rootcount;
+	int finished;
+	int owned; /* cleared once the main loop lets go of it */
+	HTAB links; /* of DUCC, hardlinked files already counted */
+	pthread_mutex_t linklock;
+} DRUN;
+
+typedef struct fwlk
+{
+	WALK walk; /* first, items are directories relative to the root */
+	ENTR *hits; /* found in the directory being walked */
+	int hitcount;
+	int hitcap;
+	char *names;
+	unsigned int namesize;
+	unsigned int namecap;
+	regex_t regex; /* each its own, glibc locks one shared */
+} FWLK;
+
+typedef struct frun
+{
+	WRUN walk; /* first, so the walkers get back to the run through it */
+	int rootfd; /* where the search started, paths are relative to it */
+	int wakefd; /* the loader pipe, walkers never touch scout */
+	char pattern[NAME_MAX + 1];
+	size_t patternlen;
+	int glob; /* or a regex, when grepping */
+	int fold; /* an all lowercase pattern ignores case */
+	int grep; /* files are searched for pattern, hits are path:line */
+	int finished;
+	int owned; /* cleared once the main loop lets go of it */
+	int woken; /* a wakeup was sent and nothing was picked up since */
+	ENTR *hits; /* handed over, names are offsets into hitnames */
+	int hitcount;
+	int hitcap;
+	char *hitnames;
+	unsigned int hitsize;
+	unsigned int hitnamecap;
+	pthread_mutex_t lock; /* guards the hand over and the flags above it */
+} FRUN;
+
+typedef struct lstc
+{
+	SDIR *dir;
+	size_t size;
+	struct lstc *chain; /* same bucket */
+	struct lstc *prev; /* least recently cached last */
+	struct lstc *next;
+} LSTC;
+
+typedef struct warm
+{
+	dev_t dev;
+	ino_t ino;
+	struct timespec mtime;
+	struct timespec ctime;
+} WARM;
+
 /* function declarations */
-static int scoutAddFile(ENTR **, char *);
+static ENTR *scoutAddEntry(SDIR *, char *);
+static int scoutAddFile(ENTR *, char *, int);
 static int scoutBuildWindows(void);
 static int scoutDestroyWindows(void);
 static int scoutCacheDir(SDIR *);
+static CACH *scoutCacheFind(char *, int);
+static int scoutCacheFlush(void);
+static int scoutCacheList(SDIR **);
+static int scoutCacheLoad(SDIR *);
+static LSTC *scoutCacheLook(struct stat *);
 static int scoutCacheSearch(SDIR *);
+static SDIR *scoutCacheUnlink(LSTC *);
+static int scoutCacheWarm(SDIR *, int);
 static int scoutClipBoard(CLPB *, SDIR *, char *);
+static int scoutCompactDir(SDIR *, unsigned int *);
 static int scoutCompareEntries(const void *, const void *);
 static int scoutCommandLine(char *);
+static int scoutCountAsync(SDIR *, ENTR *);
+static int scoutCountDir(char *);
+static int scoutCountFinish(void);
+static int scoutDuCancel(void);
+static int scoutDuClear(SDIR *);
+static int scoutDuCompare(const void *, const void *);
+static int scoutDuDone(DRUN *, WITM *, off_t);
+static int scoutDuFinish(void);
+static int scoutDuFree(DRUN *);
+static int scoutDuLink(DRUN *, struct stat *);
+static int scoutDuLoad(void);
+static DUCC *scoutDuLook(dev_t, ino_t, int);
+static int scoutDuPush(WALK *, char *, int);
+static void *scoutDuRun(void *);
+static int scoutDuSave(void);
+static int scoutDuStart(SDIR *);
+static int scoutDuToggle(void);
+static int scoutDuWalk(WALK *, WITM *);
+static int scoutFilter(void);
+static int scoutFilterApply(SDIR *, int);
+static int scoutFilterBegin(SDIR *);
+static int scoutFilterEnd(void);
+static int scoutFilterPrompt(void);
+static int scoutFilterRestore(SDIR *);
+static void *scoutFilterWorker(void *);
+static int scoutFind(int);
+static int scoutFindCancel(void);
+static int scoutFindEnd(void);
 static int scoutFindEntry(SDIR *, char *);
+static int scoutFindFinish(void);
+static int scoutFindFree(FRUN *);
+static int scoutFindHand(FWLK *);
+static ENTR *scoutFindHit(FWLK *, char *, size_t);
+static int scoutFindMatch(FRUN *, char *, char *);
+static void *scoutFindRun(void *);
+static int scoutFindStart(char *, int);
+static int scoutFindWalk(WALK *, WITM *);
 static int scoutFreeDir(SDIR **);
-static int scoutGetFileInfo(ENTR *);
-static int scoutGetFileSize(ENTR *);
-static int scoutGetFileType(ENTR *);
+static int scoutGetFileInfo(SDIR *, ENTR *, INFO *);
+static int scoutGetFileSize(SDIR *, ENTR *);
+static int scoutGetFileType(ENTR *, char *);
+static int scoutGrepContext(SDIR *, SDIR *, ENTR *);
+static int scoutGrepFile(FWLK *, int, char *, char *);
+static int scoutIdFinish(void);
+static int scoutIdName(unsigned int, int, char *, size_t);
+static int scoutIdResolve(unsigned int, int, char *, size_t);
+static IDNM *scoutIdSlot(unsigned int, int);
+static int scoutIndexDir(SDIR *);
 static int scoutInitializeCurses(void);
+static int scoutLoadAsync(SDIR *);
+static int scoutLoadCancel(int);
 static int scoutLoadDir(int, int);
-static int scoutMarkEntry(ENTR **, int );
+static int scoutLoadFinish(void);
+static int scoutLoadPrefetch(void);
+static int scoutLoadSkip(char *);
+static void *scoutLoadWorker(void *);
+static int scoutMarkEntry(ENTR *, int);
+static int scoutMergeEntries(SDIR *, int);
 static int scoutMove(int);
+static int scoutMoveLines(int);
+static int scoutPrintBlank(WINDOW *, const char *, attr_t);
+static int scoutPrintFrame(void);
 static int scoutPrintInfo(void);
+static char *scoutPrintLine(SDIR *, ENTR *, int);
 static int scoutPrintList(SDIR *, WINDOW *);
 static int scoutPrintRewindList(SDIR *);
-static int scoutPrintStringizeEntry(ENTR *, char *, int, int, int);
-static int scoutReadDir(SDIR *);
+static int scoutPrintStringizeEntry(SDIR *, ENTR *, char *, int, int, int);
+static long long scoutPrintWritten(void);
+static int scoutReadBatch(SDIR *, int, int);
+static int scoutReadDir(SDIR *, int);
+static int scoutReadMoves(int);
+static int scoutReadPoll(SDIR *);
+static int scoutResortDir(SDIR *);
+static int scoutRunThreads(void *(*)(void *), void *, size_t, int);
+static int scoutSetLink(SDIR *, ENTR *, int);
+static int scoutSetSize(SDIR *, ENTR *, const char *);
+static int scoutSetSortMode(int);
+static int scoutSetStat(ENTR *, struct stat *);
 static int scoutSetup(char *);
+static int scoutSortEntries(SDIR *, ENTR *, int);
+static void *scoutSortWorker(void *);
+static int scoutStatEntries(ENTR *, char *, int, int);
+static int scoutStatRing(ENTR *, char *, int, int);
+static void *scoutStatWorker(void *);
+static int scoutTopEntries(SDIR *, int);
 static void scoutSignalHandler(int);
 static void scoutSignalQuit(void);
+static int scoutWalkCancel(WRUN *);
+static int scoutWalkFree(WRUN *);
+static int scoutWalkInit(WRUN *, int, size_t, int (*)(WALK *, WITM *));
+static int scoutWalkPop(WALK *, WITM *);
+static int scoutWalkPush(WALK *, char *, int);
+static int scoutWalkTake(WALK *, WITM *, int);
+static void *scoutWalkWorker(void *);
+static int scoutWatchDirs(void);
+static int scoutWatchEvents(void);
+static int scoutWatchSettle(SDIR *, int, int);
+static int scoutWatchWait(void);
 
 /* variables */
 static int running = 1;
+static __thread SDIR *sortdir; /* qsort has no context argument */
+static __thread char *countbuf; /* one getdents buffer per counting thread */
 static struct mainstruct
 {
 	int cols;
@@ -118,29 +442,160 @@ static struct mainstruct
 	char *username;
 	char *hostname;
 
+	int keys[64];
+	int keycount;
+
+	int sortmode;
+	int sortrev;
+	int topview;
+
+	SDIR *filterdir; /* CURR while it shows only what matches filter */
+	char filter[NAME_MAX + 1];
+	int filterlen;
+	int filtercount; /* entries shown when filtering began */
+	int filterkept[NAME_MAX + 1]; /* matches per query length, the first ones hold them */
+	int filtertotal; /* and what entrytotal was */
+	char *filterblob; /* the names lowercased, in the order of the full listing */
+	FENT *fents; /* one per entry, moved along with it */
+	FENT *fscratch;
+	ENTR *escratch;
+
 	SDIR *dir[3];
 	WINDOW *win[3];
+	char *shown[3]; /* rows as last drawn, only the ones that differ are redrawn */
+	attr_t *shownattr[3];
+	int damaged; /* rows redrawn since the last frame */
+	int iofd;
+	struct timespec framestart;
 	CLPB *clipboard;
-	CACH *cache[HSIZE];
+	CACH *cache;
+	unsigned int cachemask;
+	unsigned int cachecount;
+	ARNA cachepaths;
+
+	int watchfd;
+	int watch[3];
+
+	pthread_mutex_t loadlock;
+	pthread_cond_t loadcond;
+	int loadpipe[2]; /* the loader says it is done through here */
+	unsigned int loadgen; /* newest preview request, older reads give up */
+	int loadbusy; /* 1 reading the preview, 2 prefetching, 3 counting, 4 looking up names */
+	char *loadpath;
+	int loadsort; /* order asked for with the queued reads */
+	int loadrev;
+	SDIR *loaded;
+	char *fetch[PSIZE]; /* neighbours to prefetch, nearest last */
+	int fetchcount;
+	CJOB *countjobs;
+	CJOB *countlast;
+	CJOB *countdone;
+
+	HTAB ids; /* of IDNM, owner and group names, guarded by loadlock */
+	int idpending;
+	int idready; /* a name came in since the footer was drawn */
+	DATC dates[DSIZE]; /* mtimes formatted, one slot per minute */
+
+	HTAB counts; /* of CNTC, only the loader touches these once it runs */
+	unsigned long countclock;
+
+	int dumode;
+	int duruns; /* walks still going, cancelled ones included */
+	int dudirty;
+	DRUN *durun;
+	HTAB du; /* of DUCC, persists across runs, guarded by dulock */
+	time_t dusession;
+	pthread_mutex_t dulock;
+	pthread_cond_t ducond;
+
+	FRUN *findrun;
+	SDIR *findsaved; /* CURR while the search results stand in for it */
+	int findgrep; /* the results are lines in files, NEXT shows them in place */
+
+	LSTC *lists[LSIZE];
+	LSTC *listfirst;
+	LSTC *listlast;
+	size_t listsize;
+	HTAB warm; /* of WARM, what is cached as far as the loader knows, guarded by loadlock */
 } *scout;
 
 /* configuration */
 #include "config.h"
 
-int scoutAddFile(ENTR **entry, char *path)
+ENTR *scoutAddEntry(SDIR *dir, char *name)
+{
+	ENTR *entry;
+	char *ext;
+	int keylen, extlen;
+	size_t namelen;
+	unsigned int i;
+	unsigned char key[KEYSIZE(NAME_MAX)];
+	unsigned char extkey[KEYSIZE(NAME_MAX)];
+
+	if (dir->entrycount == dir->entrycap)
+	{
+		dir->entrycap = dir->entrycap ? dir->entrycap * 2 : 64;
+		dir->entries = utilsRealloc(dir->entries, sizeof(ENTR) * dir->entrycap);
+	}
+
+	/* the extension is keyed once here, sorting by it then only compares keys */
+	if ((ext = strrchr(name, '.')) != NULL && ext != name)
+		extlen = utilsNameKey(ext, extkey);
+	else
+		extlen = 0;
+
+	/* extension keys, keys and names live back to back in one blob, entries keep offsets */
+	namelen = strlen(name);
+	keylen = utilsNameKey(name, key);
+	while (dir->namesize + extlen + 2 + keylen + namelen + 1 > dir->namecap)
+	{
+		dir->namecap = dir->namecap ? dir->namecap * 2 : 4096;
+		dir->names = utilsRealloc(dir->names, dir->namecap);
+	}
+
+	memcpy(dir->names + dir->namesize, extkey, extlen);
+	dir->namesize += extlen;
+	dir->names[dir->namesize++] = extlen >> 8;
+	dir->names[dir->namesize++] = extlen;
+
+	entry = &dir->entries[dir->entrycount++];
+	memset(entry, 0, sizeof(ENTR));
+	entry->name = dir->namesize;
+	entry->keylen = keylen;
+	memcpy(dir->names + dir->namesize, key, keylen);
+	memcpy(dir->names + dir->namesize + keylen, name, namelen + 1);
+	dir->namesize += keylen + namelen + 1;
+
+	/* an index that has room takes it in, positions of the others hold */
+	if (dir->index != NULL && (unsigned int) dir->entrycount * 2 <= dir->indexmask + 1)
+	{
+		for (i = utilsHash(name) & dir->indexmask; dir->index[i] != ERR; i = (i + 1) & dir->indexmask);
+		dir->index[i] = dir->entrycount - 1;
+	}
+	else
+		utilsFree(dir->index);
+
+	return entry;
+}
+
+int scoutAddFile(ENTR *entry, char *name, int dirfd)
 {
-	ENTR *temp;
 	struct stat fstat;
 
-	if (lstat(path, &fstat) != OK)
+	if (fstatat(dirfd, name, &fstat, AT_SYMLINK_NOFOLLOW) != OK)
 		return ERR;
 
-	temp = utilsCalloc(1, sizeof(ENTR));
-	temp->name = utilsMalloc(sizeof(char *) * (strlen(path) + 1));
-	strcpy(temp->name, path);
-	scoutGetFileType(temp);
-	*entry = temp;
+	scoutSetStat(entry, &fstat);
+
+	/* follow symlinks once, broken ones keep their own lstat */
+	if ((fstat.st_mode & S_IFMT) == S_IFLNK)
+	{
+		entry->flags |= ISSYM;
+		if (fstatat(dirfd, name, &fstat, 0) == OK)
+			scoutSetStat(entry, &fstat);
+	}
 
+	scoutGetFileType(entry, name);
 	return OK;
 }
 
@@ -168,6 +623,15 @@ int scoutBuildWindows(void)
 	cols = COLS / 2;
 	if ((scout->win[NEXT] = newwin(LINES - 2, cols, 1, x)) == NULL)
 		return ERR;
+
+	/* nothing is known to be on screen yet, the first print draws every row */
+	for (x = 0; x < 3; x++)
+	{
+		scout->shown[x] = utilsCalloc(scout->lines * (scout->cols + 1) + 1, sizeof(char));
+		scout->shownattr[x] = utilsMalloc(sizeof(attr_t) * (scout->lines + 1));
+		for (cols = 0; cols <= scout->lines; cols++)
+			scout->shownattr[x][cols] = (attr_t) ERR;
+	}
 	
 	return OK;
 }
@@ -185,6 +649,8 @@ int scoutDestroyWindows(void)
 			delwin(scout->win[i]);
 			scout->win[i] = NULL;
 		}
+		utilsFree(scout->shown[i]);
+		utilsFree(scout->shownattr[i]);
 	}
 
 	clear();
@@ -198,96 +664,279 @@ int scoutDestroyWindows(void)
 
 int scoutCacheSearch(SDIR *dir)
 {
-	int len;
 	int i, j;
 	CACH *temp;
-	unsigned int hash;
 
-	len = strlen(dir->path);
-	for (i = 0; i < 3 && len > 0; i++, len--);
-	hash = utilsCalcHash(&dir->path[len]);
-	
-	for (temp = scout->cache[hash]; temp != NULL; temp = temp->next)
-	{
-		if (strcmp(dir->path, temp->content->path) == 0)
-		{
-			if (temp->content->selentry != NULL)
-				if ((dir->selentry = scoutFindEntry(dir, temp->content->selentry)) == ERR)
-					dir->selentry = 0;
-			
-			if (temp->content->marked != NULL)
-				for (i = 0; i < temp->content->markedcount; i++)
-					if ((j = scoutFindEntry(dir, temp->content->marked[i])) != ERR)
-						dir->entries[j]->ismrk = 1;
+	if ((temp = scoutCacheFind(dir->path, 0)) == NULL)
+		return ERR;
 
-			return OK;
-		}
-	}
+	if (temp->content.selentry == NULL && temp->content.marked == NULL)
+		return ERR;
 
-	return ERR;
+	if (temp->content.selentry != NULL)
+		if ((dir->selentry = scoutFindEntry(dir, temp->content.selentry)) == ERR)
+			dir->selentry = 0;
+
+	if (temp->content.marked != NULL)
+		for (i = 0; i < temp->content.markedcount; i++)
+			if ((j = scoutFindEntry(dir, temp->content.marked[i])) != ERR)
+				dir->entries[j].flags |= ISMRK;
+
+	return OK;
 }
 
 int scoutCacheDir(SDIR *dir)
 {
-	int i;
-	int len;
+	CLPB state;
 	CACH *temp;
-	unsigned int hash;
 
 	if (dir->entries == NULL)
 		return OK;
 
-	len = strlen(dir->path);
-	for (i = 0; i < 3 && len > 0; i++, len--);
-	hash = utilsCalcHash(&dir->path[len]);
-	temp = scout->cache[hash];
+	memset(&state, 0, sizeof(CLPB));
+	scoutClipBoard(&state, dir, NULL);
 
-	while (temp != NULL)
+	/* the table keeps its own copy of the path */
+	utilsFree(state.path);
+
+	/* nothing worth caching, forget whatever was there */
+	if (state.selentry == NULL && state.marked == NULL)
 	{
-		if (strcmp(dir->path, temp->content->path) == OK)
-			break;
-		temp = temp->next;
+		if ((temp = scoutCacheFind(dir->path, 0)) != NULL)
+			scoutClipBoard(&temp->content, NULL, NULL);
+		return OK;
 	}
 
-	if (temp == NULL)
+	temp = scoutCacheFind(dir->path, 1);
+	scoutClipBoard(&temp->content, NULL, NULL);
+	temp->content = state;
+
+	return OK;
+}
+
+CACH *scoutCacheFind(char *path, int create)
+{
+	CACH *old;
+	unsigned int i, j, hash, size;
+
+	hash = utilsHash(path);
+	if (scout->cache != NULL)
+		for (i = hash & scout->cachemask; scout->cache[i].path != NULL; i = (i + 1) & scout->cachemask)
+			if (scout->cache[i].hash == hash && strcmp(scout->cache[i].path, path) == OK)
+				return &scout->cache[i];
+
+	if (!create)
+		return NULL;
+
+	/* slots are never freed, so grow before half of them are taken */
+	size = scout->cache != NULL ? scout->cachemask + 1 : 0;
+	if ((scout->cachecount + 1) * 2 > size)
 	{
-		temp = utilsCalloc(1, sizeof(CACH));
-		temp->content = utilsCalloc(1, sizeof(CLPB));
-		temp->next = scout->cache[hash];
-		scout->cache[hash] = temp;
+		old = scout->cache;
+		scout->cache = utilsCalloc(size ? size * 2 : 64, sizeof(CACH));
+		scout->cachemask = (size ? size * 2 : 64) - 1;
+
+		for (j = 0; j < size; j++)
+		{
+			if (old[j].path == NULL)
+				continue;
+			for (i = old[j].hash & scout->cachemask; scout->cache[i].path != NULL; i = (i + 1) & scout->cachemask);
+			scout->cache[i] = old[j];
+		}
+		utilsFree(old);
 	}
 
-	scoutClipBoard(temp->content, dir, NULL);
+	for (i = hash & scout->cachemask; scout->cache[i].path != NULL; i = (i + 1) & scout->cachemask);
+	scout->cache[i].path = utilsArenaString(&scout->cachepaths, path);
+	scout->cache[i].hash = hash;
+	scout->cachecount++;
+
+	return &scout->cache[i];
+}
+
+int scoutCacheFlush(void)
+{
+	SDIR *dir;
 
-	/* Remove cache if there's nothing worth caching */
-	if (temp->content->selentry == NULL && temp->content->marked == NULL && temp->content->action == NULL)
+	while (scout->listfirst != NULL)
 	{
-		temp = scout->cache[hash];
-		if (strcmp(dir->path, temp->content->path) == 0)
-			scout->cache[hash] = temp->next;
-		else
+		dir = scoutCacheUnlink(scout->listfirst);
+		scoutFreeDir(&dir);
+	}
+
+	return OK;
+}
+
+int scoutCacheList(SDIR **pdir)
+{
+	int i;
+	LSTC *temp;
+	SDIR *old;
+	SDIR *dir = *pdir;
+
+	if (dir == NULL)
+		return ERR;
+
+	/* only complete listings in their full order are worth keeping */
+	if (cachebudget <= 0 || dir->entries == NULL || dir->partial || dir->entrytotal != 0 || dir->ino == 0)
+		return scoutFreeDir(pdir);
+
+	/* counts still on their way would never reach it, ask again when it is back,
+	 * and recursive sizes stand in for the real ones, so those are not kept */
+	for (i = 0; i < dir->entrycount; i++)
+	{
+		if (dir->entries[i].flags & ISDU)
+			return scoutFreeDir(pdir);
+
+		if (dir->entries[i].flags & ISCNT)
 		{
-			while (temp->next != NULL)
-			{
-				if (strcmp(dir->path, temp->next->content->path) == 0)
-					break;
-				temp = temp->next;
-			}
-			temp->next = temp->next->next;
-			temp = temp->next;
+			dir->entries[i].flags &= ~ISCNT;
+			scoutSetSize(dir, &dir->entries[i], NULL);
+			dir->entries[i].linekey = 0;
+		}
+	}
+
+	for (temp = scout->lists[(dir->dev ^ dir->ino) % LSIZE]; temp != NULL; temp = temp->chain)
+	{
+		if (temp->dir->dev == dir->dev && temp->dir->ino == dir->ino)
+		{
+			old = scoutCacheUnlink(temp);
+			scoutFreeDir(&old);
+			break;
 		}
-		utilsFree(temp->content->action);
-		utilsFree(temp->content->path);
-		utilsFree(temp->content);
-		utilsFree(temp);
 	}
 
+	scoutCacheWarm(dir, 1);
+	temp = utilsCalloc(1, sizeof(LSTC));
+	temp->dir = dir;
+	temp->size = sizeof(SDIR) + sizeof(ENTR) * dir->entrycap + dir->namecap + dir->arena.total;
+	if (dir->index != NULL)
+		temp->size += sizeof(int) * (dir->indexmask + 1);
+
+	temp->chain = scout->lists[(dir->dev ^ dir->ino) % LSIZE];
+	scout->lists[(dir->dev ^ dir->ino) % LSIZE] = temp;
+	if ((temp->next = scout->listfirst) != NULL)
+		temp->next->prev = temp;
+	else
+		scout->listlast = temp;
+	scout->listfirst = temp;
+	scout->listsize += temp->size;
+
+	/* may well throw out the one just added */
+	while (scout->listsize > (size_t) cachebudget)
+	{
+		dir = scoutCacheUnlink(scout->listlast);
+		scoutFreeDir(&dir);
+	}
+
+	*pdir = NULL;
+	return OK;
+}
+
+int scoutCacheLoad(SDIR *dir)
+{
+	LSTC *temp;
+	SDIR *cached;
+	struct stat st;
+
+	if (stat(dir->path, &st) != OK)
+		return ERR;
+
+	if ((temp = scoutCacheLook(&st)) == NULL)
+		return ERR;
+
+	/* the listing moves over, the path stays the one asked for */
+	cached = scoutCacheUnlink(temp);
+	utilsFree(cached->path);
+	cached->path = dir->path;
+	*dir = *cached;
+	utilsFree(cached);
+
+	if (dir->sortmode != scout->sortmode || dir->sortrev != scout->sortrev)
+		scoutResortDir(dir);
+
+	return OK;
+}
+
+LSTC *scoutCacheLook(struct stat *st)
+{
+	LSTC *temp;
+	SDIR *cached;
+
+	for (temp = scout->lists[(st->st_dev ^ st->st_ino) % LSIZE]; temp != NULL; temp = temp->chain)
+		if (temp->dir->dev == st->st_dev && temp->dir->ino == st->st_ino)
+			break;
+
+	if (temp == NULL)
+		return NULL;
+
+	/* changed since it was read, so it is read again */
+	if (temp->dir->mtime.tv_sec != st->st_mtim.tv_sec || temp->dir->mtime.tv_nsec != st->st_mtim.tv_nsec
+	|| temp->dir->ctime.tv_sec != st->st_ctim.tv_sec || temp->dir->ctime.tv_nsec != st->st_ctim.tv_nsec)
+	{
+		cached = scoutCacheUnlink(temp);
+		scoutFreeDir(&cached);
+		return NULL;
+	}
+
+	return temp;
+}
+
+SDIR *scoutCacheUnlink(LSTC *entry)
+{
+	SDIR *dir;
+	LSTC **link;
+
+	for (link = &scout->lists[(entry->dir->dev ^ entry->dir->ino) % LSIZE]; *link != entry; link = &(*link)->chain);
+	*link = entry->chain;
+
+	if (entry->prev != NULL)
+		entry->prev->next = entry->next;
+	else
+		scout->listfirst = entry->next;
+
+	if (entry->next != NULL)
+		entry->next->prev = entry->prev;
+	else
+		scout->listlast = entry->prev;
+
+	scout->listsize -= entry->size;
+	dir = entry->dir;
+	utilsFree(entry);
+	scoutCacheWarm(dir, 0);
+
+	return dir;
+}
+
+int scoutCacheWarm(SDIR *dir, int warm)
+{
+	WARM key;
+	WARM *temp;
+
+	if (scout->loadpipe[0] < 0)
+		return ERR;
+
+	memset(&key, 0, sizeof(WARM));
+	key.dev = dir->dev;
+	key.ino = dir->ino;
+
+	pthread_mutex_lock(&scout->loadlock);
+	if (warm)
+	{
+		temp = utilsTableInsert(&scout->warm, &key);
+		temp->mtime = dir->mtime;
+		temp->ctime = dir->ctime;
+	}
+	else if ((temp = utilsTableFind(&scout->warm, &key)) != NULL)
+		utilsTableRemove(&scout->warm, temp);
+	pthread_mutex_unlock(&scout->loadlock);
+
 	return OK;
 }
 
 int scoutClipBoard(CLPB *clipboard, SDIR *dir, char *action)
 {
-	int i;
+	int i, count;
 
 	if (clipboard->path != NULL)
 		utilsFree(clipboard->path);
@@ -321,17 +970,19 @@ int scoutClipBoard(CLPB *clipboard, SDIR *dir, char *action)
 
 	if (dir->selentry != 0)
 	{
-		clipboard->selentry = utilsMalloc(sizeof(char *) * (strlen(dir->entries[dir->selentry]->name) + 1));
-		strcpy(clipboard->selentry, dir->entries[dir->selentry]->name);
+		clipboard->selentry = utilsMalloc(sizeof(char *) * (strlen(ENAME(dir, &dir->entries[dir->selentry])) + 1));
+		strcpy(clipboard->selentry, ENAME(dir, &dir->entries[dir->selentry]));
 	}
 
-	for (i = 0; i < dir->entrycount; i++)
+	/* a view hides the rest of the listing, but not its marks */
+	count = dir->entrytotal != 0 ? dir->entrytotal : dir->entrycount;
+	for (i = 0; i < count; i++)
 	{
-		if (dir->entries[i]->ismrk)
+		if (dir->entries[i].flags & ISMRK)
 		{
 			clipboard->marked = utilsRealloc(clipboard->marked, sizeof(char *) * (clipboard->markedcount + 1));
-			clipboard->marked[clipboard->markedcount] = utilsMalloc(sizeof(char *) * (strlen(dir->entries[i]->name) + 1));
-			strcpy(clipboard->marked[clipboard->markedcount++], dir->entries[i]->name);
+			clipboard->marked[clipboard->markedcount] = utilsMalloc(sizeof(char *) * (strlen(ENAME(dir, &dir->entries[i])) + 1));
+			strcpy(clipboard->marked[clipboard->markedcount++], ENAME(dir, &dir->entries[i]));
 		}
 	}
 
@@ -412,1137 +1063,4478 @@ int scoutCommandLine(char *cmd)
 	return OK;
 }
 
-int scoutCompareEntries(const void *A, const void *B)
+int scoutCompactDir(SDIR *dir, unsigned int *selname)
 {
-	ENTR *entryA = *(ENTR **) A;
-	ENTR *entryB = *(ENTR **) B;
+	int i;
+	char *names;
+	char *start;
+	size_t len, live = 0;
+	unsigned int namesize = 0;
+	unsigned int sel = *selname;
+	CHNK *chunk;
+	ARNA arena = {NULL, 0};
+	ENTR *entry;
 
-	if (entryA->type == CP_DIRECTORY && entryB->type == CP_DIRECTORY)
-		return utilsNameCMP(entryA->name, entryB->name);
-	
-	if (entryA->type != CP_DIRECTORY && entryB->type != CP_DIRECTORY)
-		return utilsNameCMP(entryA->name, entryB->name);
+	/* names of entries long gone are dropped once they make up half the blob */
+	if (dir->namedead > dir->namesize / 2)
+	{
+		names = utilsMalloc(dir->namesize - dir->namedead);
+		for (i = 0; i < dir->entrycount; i++)
+		{
+			entry = &dir->entries[i];
+			start = (char *) EEXT(dir, entry);
+			len = ENAME(dir, entry) + strlen(ENAME(dir, entry)) + 1 - start;
+			memcpy(names + namesize, start, len);
+
+			if (entry->name == sel)
+				*selname = namesize + (entry->name - (start - dir->names));
+			entry->name = namesize + (entry->name - (start - dir->names));
+			namesize += len;
+		}
 
-	if (entryA->type == CP_DIRECTORY && entryB->type != CP_DIRECTORY)
-		return -1;
+		utilsFree(dir->names);
+		dir->names = names;
+		dir->namesize = dir->namecap = namesize;
+		dir->namedead = 0;
+	}
+
+	/* likewise the display strings, outgrown lines and those of gone entries stay in the arena */
+	for (i = 0; i < dir->entrycount; i++)
+	{
+		if (dir->entries[i].sizestr != NULL)
+			live += SIZESTR;
+		if (dir->entries[i].line != NULL)
+			live += (dir->entries[i].linecap + 15) & ~15;
+		if (dir->entries[i].link != NULL)
+			live += (strlen(dir->entries[i].link) + 16) & ~15;
+	}
+
+	for (len = 0, chunk = dir->arena.chunk; chunk != NULL; chunk = chunk->next)
+		len += chunk->used;
+
+	if (dir->arena.chunk == NULL || dir->arena.chunk->next == NULL || live * 2 >= len)
+		return OK;
+
+	for (i = 0; i < dir->entrycount; i++)
+	{
+		entry = &dir->entries[i];
+		if (entry->sizestr != NULL)
+			entry->sizestr = memcpy(utilsArenaAlloc(&arena, SIZESTR), entry->sizestr, SIZESTR);
+		if (entry->line != NULL)
+			entry->line = memcpy(utilsArenaAlloc(&arena, entry->linecap), entry->line, entry->linecap);
+		if (entry->link != NULL)
+			entry->link = utilsArenaString(&arena, entry->link);
+	}
 
-	return 1;
+	utilsArenaFree(&dir->arena);
+	dir->arena = arena;
+	dir->sizefree = NULL;
+
+	return OK;
 }
 
-int scoutFindEntry(SDIR *dir, char *name)
+int scoutCompareEntries(const void *A, const void *B)
 {
-	ENTR dummy;
-	ENTR *pdummy;
-	int i, j, k, l;
+	int cmp;
+	const ENTR *entryA = A;
+	const ENTR *entryB = B;
 
-	pdummy = &dummy;
-	dummy.name = name;
-	dummy.type = CP_DIRECTORY;
+	if (entryA->type == CP_DIRECTORY && entryB->type != CP_DIRECTORY)
+		return -1;
 
-	i = 0;
-	j = dir->entrycount;
-	l = (j - i) / 2;
+	if (entryA->type != CP_DIRECTORY && entryB->type == CP_DIRECTORY)
+		return 1;
 
-	while ((k = scoutCompareEntries(&pdummy, &dir->entries[l])) != 0)
+	/* everything but name order falls back to it on ties */
+	switch (sortdir->sortmode)
 	{
-		if (j - i == 1)
-		{
-			if (dummy.type != CP_DEFAULT)
-			{
-				i = 0;
-				j = dir->entrycount;
-				l = (j - i) / 2;
-				dummy.type = CP_DEFAULT;
-				continue;
-			}
-			else
-				return ERR;
-		}
+		case BYSIZE:
+			cmp = (entryA->size < entryB->size) - (entryA->size > entryB->size);
+			break;
 
-		if (k < 0)
-		{
-			j = l;
-			l = (j - i) / 2;
-		}
-		else
-		{
-			i = l;
-			l = l + (j - i) / 2;
-		}
+		case BYTIME:
+			cmp = (entryA->mtime < entryB->mtime) - (entryA->mtime > entryB->mtime);
+			break;
+
+		case BYEXT:
+			cmp = utilsKeyCMP(EEXT(sortdir, entryA), EXTLEN(sortdir, entryA), EEXT(sortdir, entryB), EXTLEN(sortdir, entryB));
+			break;
+
+		case BYTYPE:
+			cmp = entryA->type - entryB->type;
+			break;
+
+		default:
+			cmp = 0;
 	}
 
-	return l;
+	if (cmp == 0)
+		cmp = utilsKeyCMP(EKEY(sortdir, entryA), entryA->keylen, EKEY(sortdir, entryB), entryB->keylen);
+
+	return sortdir->sortrev ? -cmp : cmp;
 }
 
-int scoutFreeDir(SDIR **pdir)
+int scoutCountAsync(SDIR *dir, ENTR *entry)
 {
-	int i = 0;
-	SDIR *dir;
+	CJOB *job;
 
-	if ((dir = *pdir) == NULL)
+	if (scout->loadpipe[0] < 0)
 		return ERR;
 
-	if (dir->entries != NULL)
-	{
-		while (i < dir->entrycount)
-		{
-			utilsFree(dir->entries[i]->size);
-			utilsFree(dir->entries[i]->name);
-			utilsFree(dir->entries[i++]);
-		}
-		utilsFree(dir->entries);
-	}
-	utilsFree(dir->path);
-	utilsFree(dir);
+	job = utilsCalloc(1, sizeof(CJOB));
+	job->path = utilsMalloc(sizeof(char *) * (strlen(dir->path) + 1));
+	strcpy(job->path, dir->path);
+	job->name = utilsMalloc(sizeof(char *) * (strlen(ENAME(dir, entry)) + 1));
+	strcpy(job->name, ENAME(dir, entry));
+
+	pthread_mutex_lock(&scout->loadlock);
+	if (scout->countjobs != NULL)
+		scout->countlast->next = job;
+	else
+		scout->countjobs = job;
+	scout->countlast = job;
+	pthread_cond_broadcast(&scout->loadcond);
+	pthread_mutex_unlock(&scout->loadlock);
 
-	*pdir = NULL;
 	return OK;
 }
 
-int scoutGetFileInfo(ENTR *entry)
+int scoutCountDir(char *path)
 {
-	int i = 0;
-	time_t time;
-	struct tm stime;
-	struct stat fstat;
-	char permsbuf[12];
-	char ctimebuf[18];
-	struct passwd *pws;
-	char truepath[PATH_MAX];
-
-	if (lstat(entry->name, &fstat) != OK)
+	int fd;
+	long n, i;
+	DENT *d;
+	CNTC key;
+	CNTC *temp;
+	unsigned int k;
+	struct stat st;
+	int count = 0;
+
+	if ((fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
 		return ERR;
 
-	if ((fstat.st_mode & S_IFMT) == S_IFLNK)
+	/* a directory keeps its mtime as long as nothing is added or removed */
+	if (fstat(fd, &st) != OK)
+		st.st_ino = 0;
+
+	memset(&key, 0, sizeof(CNTC));
+	key.dev = st.st_dev;
+	key.ino = st.st_ino;
+	if ((temp = utilsTableFind(&scout->counts, &key)) != NULL
+	&& temp->mtime.tv_sec == st.st_mtim.tv_sec && temp->mtime.tv_nsec == st.st_mtim.tv_nsec)
 	{
-		if (realpath(entry->name, truepath) != NULL)
+		temp->stamp = ++scout->countclock;
+		close(fd);
+		return temp->count;
+	}
+
+	if (countbuf == NULL)
+		countbuf = utilsMalloc(dentbufsize);
+	while ((n = utilsGetDents(fd, countbuf, dentbufsize)) > 0)
+	{
+		for (i = 0; i < n; i += d->reclen)
 		{
-			if (lstat(truepath, &fstat) == OK)
-				permsbuf[i++] = 'l';
-			else if (lstat(entry->name, &fstat) != OK)
-				return ERR;
+			d = (DENT *) (countbuf + i);
+			if (strcmp(d->name, ".") != OK && strcmp(d->name, "..") != OK)
+				count++;
 		}
-		else
-			truepath[0] = '\0'; /* marks broken symlinks */
 	}
+	close(fd);
 
-	if (i == 0)
+	if (n < 0 || st.st_ino == 0)
+		return n < 0 ? ERR : count;
+
+	/* a full table drops everything not used within the last half of its size */
+	if (scout->counts.count >= (unsigned int) countcache)
 	{
-		switch (fstat.st_mode & S_IFMT)
+		for (k = 0; (temp = utilsTableNext(&scout->counts, &k)) != NULL;)
 		{
-			case S_IFREG:
-				permsbuf[i++] = '-';
-				break;
-			case S_IFDIR:
-				permsbuf[i++] = 'd';
-				break;
-			case S_IFLNK:
-				permsbuf[i++] = 'l';
-				break;
-			case S_IFCHR:
-				permsbuf[i++] = 'c';
-				break;
-			case S_IFBLK:
-				permsbuf[i++] = 'b';
-				break;
-			case S_IFSOCK:
-				permsbuf[i++] = 's';
-				break;
-			case S_IFIFO:
-				permsbuf[i++] = 'f';
-				break;
-
-			default:
-				permsbuf[i++] = '-';
-				break;
+			if (temp->stamp + countcache / 2 < scout->countclock)
+			{
+				utilsTableRemove(&scout->counts, temp);
+				k--;
+			}
 		}
 	}
 
-	permsbuf[i++] = fstat.st_mode & S_IRUSR ? 'r' : '-';
-	permsbuf[i++] = fstat.st_mode & S_IWUSR ? 'w' : '-';
-	permsbuf[i++] = fstat.st_mode & S_IXUSR ? 'x' : '-';
-	permsbuf[i++] = fstat.st_mode & S_IRGRP ? 'r' : '-';
-	permsbuf[i++] = fstat.st_mode & S_IWGRP ? 'w' : '-';
-	permsbuf[i++] = fstat.st_mode & S_IXGRP ? 'x' : '-';
-	permsbuf[i++] = fstat.st_mode & S_IROTH ? 'r' : '-';
-	permsbuf[i++] = fstat.st_mode & S_IWOTH ? 'w' : '-';
-	permsbuf[i++] = fstat.st_mode & S_IXOTH ? 'x' : '-';
-	permsbuf[i] = '\0';
-
-	entry->perms = utilsMalloc(sizeof(char *) * (strlen(permsbuf) + 1));
-	strcpy(entry->perms, permsbuf);
+	/* an entry gone stale is taken over in place */
+	temp = utilsTableInsert(&scout->counts, &key);
+	temp->mtime = st.st_mtim;
+	temp->count = count;
+	temp->stamp = ++scout->countclock;
 
-	if ((pws = getpwuid(fstat.st_uid)) == NULL)
-		return ERR;
-	entry->users = utilsMalloc(sizeof(char *) * (strlen(pws->pw_name) + 1));
-	strcpy(entry->users, pws->pw_name);
-
-	time = fstat.st_mtime;
-	localtime_r(&time, &stime);
-	strftime(ctimebuf, 18, "%Y-%m-%d %H:%M", &stime);
-	entry->dates = utilsMalloc(sizeof(char *) * (strlen(ctimebuf) + 1));
-	strcpy(entry->dates, ctimebuf);
-
-	if (entry->issym && truepath[0] != '\0')
-	{
-		entry->lpath = utilsMalloc(sizeof(char *) * (strlen(truepath) + 1));
-		strcpy(entry->lpath, truepath);
-	}
-	
-	return OK;
+	return count;
 }
 
-int scoutGetFileSize(ENTR *entry)
+int scoutCountFinish(void)
 {
-	int i;
-	DIR *pdir;
-	float fsize;
-	char sbuf[60];
+	int i, j;
+	SDIR *dir;
+	CJOB *job;
+	CJOB *done;
 	char sizebuf[64];
-	struct dirent *d;
-	struct stat fstat;
-	unsigned dsize = 0;
-	char truepath[PATH_MAX];
-	char sizearr[] = "BKMGTPEZY";
+	int print[3] = {0, 0, 0};
 
-	if (lstat(entry->name, &fstat) != OK)
-	{
-		TOTALFAILURE:
-		entry->size = utilsMalloc(sizeof(char *) * 2);
-		strcpy(entry->size, "?");
-		entry->isatu = ERR;
-		return ERR;		
-	}
+	pthread_mutex_lock(&scout->loadlock);
+	done = scout->countdone;
+	scout->countdone = NULL;
+	pthread_mutex_unlock(&scout->loadlock);
 
-	sizebuf[0] = '\0';
-	if ((fstat.st_mode & S_IFMT) == S_IFLNK)
+	/* results land in whichever pane still shows that directory */
+	while ((job = done) != NULL)
 	{
-		if (realpath(entry->name, truepath) != NULL)
+		for (i = PREV; i <= NEXT; i++)
 		{
-			if (lstat(truepath, &fstat) == OK)
-				strcat(sizebuf, "-> ");
-			else if (lstat(entry->name, &fstat) != OK)
-				goto TOTALFAILURE;
-		}
-		else
-			strcat(sizebuf, "-> ");
-	}
+			if ((dir = scout->dir[i]) == NULL || dir->path == NULL || strcmp(dir->path, job->path) != OK)
+				continue;
 
-	switch (fstat.st_mode & S_IFMT)
-	{
-		case S_IFREG:
-			fsize = fstat.st_size;
-			for (i = 0; i < 9 && fsize > 1024.00; i++)
-				fsize /= 1024.00;
+			if ((j = scoutFindEntry(dir, job->name)) == ERR || !(dir->entries[j].flags & ISCNT))
+				continue;
 
-			sprintf(sbuf, (i > 0) ? "%.1f %c" : "%.0f %c", fsize, sizearr[i]);
-			strcat(sizebuf, sbuf);
-			break;
-		case S_IFDIR:
-			if ((pdir = opendir(entry->issym ? truepath : entry->name)) != NULL)
+			dir->entries[j].flags &= ~ISCNT;
+			if (job->count == ERR)
 			{
-				while ((d = readdir(pdir)) != NULL)
-				{
-					if (strcmp(d->d_name, ".") == OK 
-					|| strcmp(d->d_name, "..") == OK)
-						continue;
-					else
-						dsize++;
-				}
-				sprintf(sbuf, "%d", dsize);
-				strcat(sizebuf, sbuf);
-				closedir(pdir);
+				dir->entries[j].flags |= NOACC;
+				sprintf(sizebuf, "%sN/A", dir->entries[j].flags & ISSYM ? "-> " : "");
 			}
 			else
-			{
-				strcat(sizebuf, "N/A");
-				entry->isatu = ERR;
-			}
-			break;
-		case S_IFBLK:
-			strcat(sizebuf, "block");
-			break;
-		case S_IFSOCK:
-			strcat(sizebuf, "sock");
-			break;
-		case S_IFIFO:
-			strcat(sizebuf, "fifo");
-			break;
-		case S_IFCHR:
-			strcat(sizebuf, "dev");
-			break;
+				sprintf(sizebuf, "%s%d", dir->entries[j].flags & ISSYM ? "-> " : "", job->count);
+			scoutSetSize(dir, &dir->entries[j], sizebuf);
+			dir->entries[j].linekey = 0;
+			print[i] = 1;
+		}
 
-		default:
-			strcat(sizebuf, "N/A");
-			entry->isatu = ERR;
-			break;
+		done = job->next;
+		utilsFree(job->path);
+		utilsFree(job->name);
+		utilsFree(job);
 	}
 
-	entry->size = utilsMalloc(sizeof(char *) * (strlen(sizebuf) + 1));
-	strcpy(entry->size, sizebuf);
+	for (i = PREV; i <= NEXT; i++)
+		if (print[i])
+			scoutPrintList(scout->dir[i], scout->win[i]);
+
 	return OK;
 }
 
-int scoutGetFileType(ENTR *entry)
+int scoutDuCancel(void)
 {
-	int i;
-	char *ext;
-	struct stat fstat;
-	char truepath[PATH_MAX];
+	int finished;
+	DRUN *run;
 
-	if (lstat(entry->name, &fstat) != OK)
+	if ((run = scout->durun) == NULL)
 		return ERR;
 
-	entry->issym = 0;
-	if ((fstat.st_mode & S_IFMT) == S_IFLNK)
-	{
-		if (realpath(entry->name, truepath) != NULL)
-		{
-			if (lstat(truepath, &fstat) == OK)
-				entry->issym = 1;
-			else if (lstat(entry->name, &fstat) != OK)
-				return ERR;
-		}
-		else
-			entry->issym = 1;
-	}
-
-	switch (fstat.st_mode & S_IFMT)
-	{
-		case S_IFDIR:
-			entry->type = CP_DIRECTORY;
-			break;
-		case S_IFSOCK:
-			entry->type = CP_SOCK;
-			break;
-		case S_IFIFO:
-			entry->type = CP_FIFO;
-			break;
-		case S_IFCHR:
-			entry->type = CP_CHR;
-			break;
-		case S_IFBLK:
-			entry->type = CP_BLK;
-			break;
-		case S_IFREG:
-			if ((fstat.st_mode & S_IXUSR) 
-			&& (fstat.st_mode & S_IXOTH) 
-			&& (fstat.st_mode & S_IXGRP))
-			{
-				entry->type = CP_EXECUTABLE;
-				return OK;
-			}
+	/* whoever is last frees it, the walkers stop at their next directory */
+	scout->durun = NULL;
+	scoutWalkCancel(&run->walk);
+	pthread_mutex_lock(&scout->dulock);
+	run->owned = 0;
+	finished = run->finished;
+	pthread_mutex_unlock(&scout->dulock);
 
-			if ((ext = strrchr(entry->name, '.')) == NULL || *(++ext) == '\0')
-			{
-				entry->type = CP_DEFAULT;
-				return OK;
-			}
+	if (finished)
+		scoutDuFree(run);
 
-			for (i = 0; i < ARRLENGTH(extVideo); i++)
-			{
-				if (strcmp(ext, extVideo[i]) == OK)
-				{
-					entry->type = CP_VIDEO;
-					return OK;
-				}
-			}
+	return OK;
+}
 
-			for (i = 0; i < ARRLENGTH(extAudio); i++)
-			{
-				if (strcmp(ext, extAudio[i]) == OK)
-				{
-					entry->type = CP_AUDIO;
-					return OK;
-				}
-			}
+int scoutDuClear(SDIR *dir)
+{
+	int i, fd;
+	int changed = 0;
+	struct stat st;
 
-			for (i = 0; i < ARRLENGTH(extImage); i++)
-			{
-				if (strcmp(ext, extImage[i]) == OK)
-				{
-					entry->type = CP_IMAGE;
-					return OK;
-				}
-			}
+	if (dir == NULL || dir->entries == NULL)
+		return ERR;
 
-			for (i = 0; i < ARRLENGTH(extArchive); i++)
-			{
-				if (strcmp(ext, extArchive[i]) == OK)
-				{
-					entry->type = CP_ARCHIVE;
-					return OK;
-				}
-			}
+	/* directories get their own size back, and a column to fill in again */
+	fd = open(dir->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	for (i = 0; i < dir->entrycount; i++)
+	{
+		if ((dir->entries[i].mode & S_IFMT) != S_IFDIR)
+			continue;
 
-			entry->type = CP_DEFAULT;
-			break;
+		if ((dir->entries[i].flags & ISDU) && fd >= 0
+		&& fstatat(fd, ENAME(dir, &dir->entries[i]), &st, AT_SYMLINK_NOFOLLOW) == OK)
+			dir->entries[i].size = st.st_size;
 
-		default: entry->type = CP_DEFAULT;
+		changed |= dir->entries[i].flags & ISDU;
+		dir->entries[i].flags &= ~(ISDU | ISCNT);
+		scoutSetSize(dir, &dir->entries[i], NULL);
+		dir->entries[i].linekey = 0;
 	}
 
+	if (fd >= 0)
+		close(fd);
+
+	if (changed && dir->sortmode == BYSIZE && dir->entrytotal == 0)
+		scoutResortDir(dir);
+
 	return OK;
 }
 
-int scoutInitializeCurses(void)
+int scoutDuCompare(const void *A, const void *B)
 {
-	int i;
-	int temp;
-
-	if (initscr() == NULL)
-		return ERR;
-	/* something something TODO */
-	cbreak();
-	noecho();
-	curs_set(0);
-	start_color();
-	use_default_colors();
-
-	temp = ARRLENGTH(nColors);
-	for (i = 0; i < temp; i++)
-		init_pair(nColors[i][0], nColors[i][1], nColors[i][2]);
+	const DUCC *recA = *(DUCC * const *) A;
+	const DUCC *recB = *(DUCC * const *) B;
 
-	refresh();
+	return (recA->used < recB->used) - (recA->used > recB->used);
+}
 
-	keypad(stdscr, TRUE);
+int scoutDuDone(DRUN *run, WITM *item, off_t size)
+{
+	/* children were pushed first, so a root never reaches zero early */
+	__atomic_add_fetch(&run->sizes[item->root], size, __ATOMIC_RELAXED);
+	__atomic_sub_fetch(&run->pending[item->root], 1, __ATOMIC_RELEASE);
 
 	return OK;
 }
 
-int scoutLoadDir(int dir, int mode)
+int scoutDuFinish(void)
 {
 	int i, j;
-	char *temp;
-	ENTR *selentry;
+	int changed = 0;
+	DRUN *run = scout->durun;
+	SDIR *dir = scout->dir[CURR];
 
-	switch (dir)
+	if (run == NULL || strcmp(run->path, dir->path) != OK)
+		return ERR;
+
+	/* a root is done once none of its directories is left */
+	for (i = 0; i < run->rootcount; i++)
 	{
-		case CURR:
-			if (mode == LOAD)
-				scoutReadDir(scout->dir[CURR]);
+		if (run->applied[i] || __atomic_load_n(&run->pending[i], __ATOMIC_ACQUIRE) != 0)
+			continue;
 
-			scoutPrintRewindList(scout->dir[CURR]);
+		run->applied[i] = 1;
+		if ((j = scoutFindEntry(dir, run->names[i])) == ERR)
+			continue;
 
-			for (i = scout->dir[CURR]->firstentry, j = 0; i < scout->dir[CURR]->entrycount && j < scout->lines; i++, j++)
-				if (scout->dir[CURR]->entries[i]->size == NULL)
-					scoutGetFileSize(scout->dir[CURR]->entries[i]);
+		dir->entries[j].size = __atomic_load_n(&run->sizes[i], __ATOMIC_RELAXED);
+		dir->entries[j].flags &= ~ISCNT;
+		dir->entries[j].flags |= ISDU;
+		scoutSetSize(dir, &dir->entries[j], NULL);
+		dir->entries[j].linekey = 0;
+		changed = 1;
+	}
 
-			scoutPrintList(scout->dir[CURR], scout->win[CURR]);
-			return OK;
+	if (changed && dir->sortmode == BYSIZE && dir->entrytotal == 0)
+		scoutResortDir(dir);
 
-		case NEXT:
-			if (mode == LOAD)
-				scout->dir[NEXT] = utilsCalloc(1, sizeof(SDIR));
+	return changed ? OK : ERR;
+}
 
-			if (scout->dir[CURR]->entries != NULL)
-				selentry = scout->dir[CURR]->entries[scout->dir[CURR]->selentry];
-			else
-				selentry = NULL;
+int scoutDuFree(DRUN *run)
+{
+	int i;
 
-			if (selentry == NULL || selentry->type != CP_DIRECTORY)
-			{
-				wclear(scout->win[NEXT]);
-				wrefresh(scout->win[NEXT]);
-				return OK;
-			}
+	for (i = 0; i < run->rootcount; i++)
+		utilsFree(run->names[i]);
 
-			if (selentry->isatu != OK)
-			{
-				wclear(scout->win[NEXT]);
-				wattron(scout->win[NEXT], COLOR_PAIR(CP_ERROR));
-				mvwprintw(scout->win[NEXT], 0, 0, errorNoAccess);
-				wattrset(scout->win[NEXT], COLOR_PAIR(CP_ERROR));
-				wrefresh(scout->win[NEXT]);
-				return OK;
-			}
+	scoutWalkFree(&run->walk);
+	pthread_mutex_destroy(&run->linklock);
+	utilsFree(run->names);
+	utilsFree(run->sizes);
+	utilsFree(run->pending);
+	utilsFree(run->applied);
+	utilsTableFree(&run->links);
+	utilsFree(run->path);
+	utilsFree(run);
 
-			if (mode == LOAD)
-			{
-				scout->dir[NEXT]->path = utilsMalloc(sizeof(char *) * (strlen(selentry->name) + 3));
-				if (scout->dir[CURR]->path[1] != '\0')
-					sprintf(scout->dir[NEXT]->path, "%s/%s", scout->dir[CURR]->path, selentry->name);
-				else
-					sprintf(scout->dir[NEXT]->path, "/%s", selentry->name);
-				scoutReadDir(scout->dir[NEXT]);
-				scoutCacheSearch(scout->dir[NEXT]);
-			}
+	return OK;
+}
 
-			scoutPrintRewindList(scout->dir[NEXT]);
-			scoutPrintList(scout->dir[NEXT], scout->win[NEXT]);
-			return OK;
+int scoutDuLink(DRUN *run, struct stat *st)
+{
+	DUCC key;
+	unsigned int count;
 
-		case PREV:
-			if (mode == LOAD)
-				scout->dir[PREV] = utilsCalloc(1, sizeof(SDIR));
-					
-			if (scout->dir[CURR]->path[1] == '\0')
-			{
-				wclear(scout->win[PREV]);
-				wrefresh(scout->win[PREV]);
-				return OK;
-			}
+	memset(&key, 0, sizeof(DUCC));
+	key.dev = st->st_dev;
+	key.ino = st->st_ino;
 
-			if (mode == LOAD)
-			{
-				i = 0;
-				while (scout->dir[CURR]->path[++i] != '\0');
-				while (scout->dir[CURR]->path[--i] != '/');
-						
-				scout->dir[PREV]->path = utilsMalloc(sizeof(char *) * (i + 2));
-				strncpy(scout->dir[PREV]->path, scout->dir[CURR]->path, i + 1);
-				scout->dir[PREV]->path[i ? i : 1] = '\0';
-				scoutReadDir(scout->dir[PREV]);
+	/* the first path to a hardlinked file gets to count it */
+	pthread_mutex_lock(&run->linklock);
+	count = run->links.count;
+	utilsTableInsert(&run->links, &key);
+	count = run->links.count - count;
+	pthread_mutex_unlock(&run->linklock);
 
-				if (scoutCacheSearch(scout->dir[PREV]) != OK)
-				{
-					temp = strrchr(scout->dir[CURR]->path, '/') + 1;
-					if ((scout->dir[PREV]->selentry = scoutFindEntry(scout->dir[PREV], temp)) == ERR)
-						scout->dir[PREV]->selentry = 0;
-				}
-			}
+	return count ? OK : ERR;
+}
 
-			scoutPrintRewindList(scout->dir[PREV]);
-			scoutPrintList(scout->dir[PREV], scout->win[PREV]);
-			return OK;
-		
-		default:
+int scoutDuLoad(void)
+{
+	FILE *fp;
+	DUCC rec;
+	DUCC *temp;
+	char *home;
+	char magic[8];
+	unsigned int head[2];
+	char path[PATH_MAX];
+
+	if ((home = getenv("HOME")) == NULL)
+		return ERR;
+
+	snprintf(path, sizeof(path), "%s/%s", home, dufile);
+	if ((fp = fopen(path, "rb")) == NULL)
+		return ERR;
+
+	/* a file from another build or architecture is ignored, by record size and byte order */
+	if (fread(magic, sizeof(magic), 1, fp) != 1 || memcmp(magic, DUMAGIC, sizeof(magic)) != OK
+	|| fread(head, sizeof(head), 1, fp) != 1 || head[0] != sizeof(DUCC) || head[1] != DUORDER)
+	{
+		fclose(fp);
+		return ERR;
+	}
+
+	pthread_mutex_lock(&scout->dulock);
+	while (fread(&rec, sizeof(DUCC), 1, fp) == 1)
+	{
+		if (rec.ino == 0)
+			continue;
+		temp = scoutDuLook(rec.dev, rec.ino, 1);
+		*temp = rec;
+	}
+	pthread_mutex_unlock(&scout->dulock);
+
+	fclose(fp);
+	return OK;
+}
+
+DUCC *scoutDuLook(dev_t dev, ino_t ino, int create)
+{
+	DUCC key;
+
+	memset(&key, 0, sizeof(DUCC));
+	key.dev = dev;
+	key.ino = ino;
+
+	return create ? utilsTableInsert(&scout->du, &key) : utilsTableFind(&scout->du, &key);
+}
+
+int scoutDuPush(WALK *walker, char *path, int root)
+{
+	DRUN *run = (DRUN *) walker->run;
+
+	__atomic_add_fetch(&run->pending[root], 1, __ATOMIC_RELAXED);
+	return scoutWalkPush(walker, path, root);
+}
+
+void *scoutDuRun(void *arg)
+{
+	int owned;
+	DRUN *run = arg;
+
+	scoutRunThreads(scoutWalkWorker, run->walk.walkers, run->walk.size, run->walk.count);
+
+	/* the wakeup is sent under the lock, quitting waits for it */
+	pthread_mutex_lock(&scout->dulock);
+	run->finished = 1;
+	scout->duruns--;
+	if ((owned = run->owned) && scout->loadpipe[1] >= 0)
+		write(scout->loadpipe[1], "", 1);
+	pthread_cond_broadcast(&scout->ducond);
+	pthread_mutex_unlock(&scout->dulock);
+
+	if (!owned)
+		scoutDuFree(run);
+
+	return NULL;
+}
+
+int scoutDuSave(void)
+{
+	FILE *fp;
+	DUCC *rec;
+	DUCC **recs;
+	char *home;
+	unsigned int i, n;
+	char path[PATH_MAX];
+	char temp[PATH_MAX];
+	unsigned int head[2] = {sizeof(DUCC), DUORDER};
+
+	if (!scout->dudirty || scout->du.count == 0 || (home = getenv("HOME")) == NULL)
+		return ERR;
+
+	/* written aside and renamed, so a crash never leaves half a file */
+	snprintf(path, sizeof(path), "%s/%s", home, dufile);
+	snprintf(temp, sizeof(temp), "%s/%s.tmp", home, dufile);
+	if ((fp = fopen(temp, "wb")) == NULL)
+		return ERR;
+
+	/* past ducache records, the ones walked longest ago are left out */
+	recs = utilsMalloc(sizeof(DUCC *) * scout->du.count);
+	for (i = n = 0; (rec = utilsTableNext(&scout->du, &i)) != NULL;)
+		recs[n++] = rec;
+	if (n > (unsigned int) ducache)
+	{
+		qsort(recs, n, sizeof(DUCC *), scoutDuCompare);
+		n = ducache;
+	}
+
+	fwrite(DUMAGIC, strlen(DUMAGIC), 1, fp);
+	fwrite(head, sizeof(head), 1, fp);
+	for (i = 0; i < n; i++)
+		fwrite(recs[i], sizeof(DUCC), 1, fp);
+	utilsFree(recs);
+
+	if (fclose(fp) != OK || rename(temp, path) != OK)
+	{
+		unlink(temp);
+		return ERR;
+	}
+
+	scout->dudirty = 0;
+	return OK;
+}
+
+int scoutDuStart(SDIR *dir)
+{
+	int i, n;
+	char *path;
+	DRUN *run;
+	ENTR *entry;
+	pthread_t thread;
+	struct stat st;
+
+	if (!scout->dumode || dir->entries == NULL || dir->partial)
+		return ERR;
+
+	if (scout->durun != NULL && strcmp(scout->durun->path, dir->path) == OK)
+		return OK;
+
+	scoutDuCancel();
+	if (stat(dir->path, &st) != OK)
+		return ERR;
+
+	run = utilsCalloc(1, sizeof(DRUN));
+	run->path = utilsMalloc(sizeof(char *) * (strlen(dir->path) + 1));
+	strcpy(run->path, dir->path);
+	run->dev = st.st_dev;
+	run->owned = 1;
+	pthread_mutex_init(&run->linklock, NULL);
+	utilsTableInit(&run->links, sizeof(DUCC), offsetof(DUCC, mtime));
+
+	scoutWalkInit(&run->walk, duthreads, sizeof(WALK), scoutDuWalk);
+
+	/* every directory shown is a root, symlinks to them are not followed */
+	for (i = n = 0; i < dir->entrycount; i++)
+		if (dir->entries[i].type == CP_DIRECTORY && !(dir->entries[i].flags & (ISSYM | NOACC)))
+			n++;
+
+	run->names = utilsCalloc(n ? n : 1, sizeof(char *));
+	run->sizes = utilsCalloc(n ? n : 1, sizeof(off_t));
+	run->pending = utilsCalloc(n ? n : 1, sizeof(int));
+	run->applied = utilsCalloc(n ? n : 1, sizeof(int));
+
+	for (i = 0; i < dir->entrycount; i++)
+	{
+		entry = &dir->entries[i];
+		if (entry->type != CP_DIRECTORY || (entry->flags & (ISSYM | NOACC)))
+			continue;
+
+		n = run->rootcount++;
+		run->names[n] = utilsMalloc(sizeof(char *) * (strlen(ENAME(dir, entry)) + 1));
+		strcpy(run->names[n], ENAME(dir, entry));
+
+		path = utilsMalloc(sizeof(char *) * (strlen(dir->path) + strlen(ENAME(dir, entry)) + 2));
+		if (dir->path[1] != '\0')
+			sprintf(path, "%s/%s", dir->path, ENAME(dir, entry));
+		else
+			sprintf(path, "/%s", ENAME(dir, entry));
+		scoutDuPush(WALKER(&run->walk, n % run->walk.count), path, n);
+	}
+
+	scout->durun = run;
+	pthread_mutex_lock(&scout->dulock);
+	scout->duruns++;
+	pthread_mutex_unlock(&scout->dulock);
+
+	/* without a loader to wake the main loop, the walk is waited for */
+	if (scout->loadpipe[0] < 0 || pthread_create(&thread, NULL, scoutDuRun, run) != OK)
+		scoutDuRun(run);
+	else
+		pthread_detach(thread);
+
+	return OK;
+}
+
+int scoutDuToggle(void)
+{
+	int i;
+
+	scout->dumode = !scout->dumode;
+
+	if (scout->dumode && scout->du.slots == NULL)
+		scoutDuLoad();
+
+	/* sizes are formatted again either way */
+	for (i = PREV; i <= NEXT; i++)
+		scoutDuClear(scout->dir[i]);
+
+	if (!scout->dumode)
+		scoutDuCancel();
+
+	scoutLoadDir(PREV, RELOAD);
+	scoutLoadDir(CURR, RELOAD);
+	scoutPrintInfo();
+
+	return OK;
+}
+
+int scoutDuWalk(WALK *walker, WITM *item)
+{
+	int fd, fresh;
+	int links = 0;
+	long n, i;
+	DENT *d;
+	DUCC *cached;
+	char *path;
+	off_t size = 0;
+	off_t linked = 0;
+	struct stat st, sub;
+	DRUN *run = (DRUN *) walker->run;
+
+	if ((fd = open(item->path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)) < 0)
+		return scoutDuDone(run, item, 0);
+
+	if (fstat(fd, &st) != OK)
+	{
+		close(fd);
+		return scoutDuDone(run, item, 0);
+	}
+
+	/* unchanged since last time, so only its subdirectories need a look */
+	pthread_mutex_lock(&scout->dulock);
+	cached = scoutDuLook(st.st_dev, st.st_ino, 0);
+	if ((fresh = cached != NULL && cached->mtime.tv_sec == st.st_mtim.tv_sec && cached->mtime.tv_nsec == st.st_mtim.tv_nsec))
+	{
+		size = cached->size;
+		links = cached->links;
+		if (cached->used != scout->dusession)
+		{
+			cached->used = scout->dusession;
+			scout->dudirty = 1;
+		}
+	}
+	pthread_mutex_unlock(&scout->dulock);
+
+	while ((n = utilsGetDents(fd, walker->buf, dentbufsize)) > 0)
+	{
+		for (i = 0; i < n; i += d->reclen)
+		{
+			d = (DENT *) (walker->buf + i);
+			if (strcmp(d->name, ".") == OK || strcmp(d->name, "..") == OK)
+				continue;
+
+			/* the type from getdents spares a stat for the files of a fresh directory without hardlinks */
+			if (fresh && links == 0 && d->type != DT_DIR && d->type != DT_UNKNOWN)
+				continue;
+
+			if (fstatat(fd, d->name, &sub, AT_SYMLINK_NOFOLLOW) != OK)
+				continue;
+
+			if (S_ISDIR(sub.st_mode))
+			{
+				if (sub.st_dev != run->dev)
+					continue;
+
+				path = utilsMalloc(sizeof(char *) * (strlen(item->path) + strlen(d->name) + 2));
+				sprintf(path, "%s/%s", item->path, d->name);
+				scoutDuPush(walker, path, item->root);
+			}
+			else if (sub.st_nlink > 1)
+			{
+				/* whoever reaches one first in this walk counts it, so it never goes into the cache */
+				if (!fresh)
+					links++;
+				if (scoutDuLink(run, &sub) == OK)
+					linked += (off_t) sub.st_blocks * 512;
+			}
+			else if (!fresh)
+				size += (off_t) sub.st_blocks * 512;
+		}
+	}
+	close(fd);
+
+	if (!fresh && n == 0)
+	{
+		pthread_mutex_lock(&scout->dulock);
+		cached = scoutDuLook(st.st_dev, st.st_ino, 1);
+		cached->mtime = st.st_mtim;
+		cached->size = size;
+		cached->links = links;
+		cached->used = scout->dusession;
+		scout->dudirty = 1;
+		pthread_mutex_unlock(&scout->dulock);
+	}
+
+	return scoutDuDone(run, item, size + linked + (off_t) st.st_blocks * 512);
+}
+
+int scoutFilter(void)
+{
+	int c;
+	int done = 0;
+	SDIR *buf;
+	SDIR *dir = scout->dir[CURR];
+
+	/* a filter still in place is taken up where it was left */
+	if (scout->filterdir != dir)
+	{
+		if (scoutFilterBegin(dir) != OK)
 			return ERR;
+		scout->filter[scout->filterlen = 0] = '\0';
 	}
-	return ERR;
+	curs_set(1);
+
+	while (!done && scout->filterdir == dir)
+	{
+		/* as in scoutRun, whatever the loader or inotify bring in shows while typing */
+		nodelay(stdscr, TRUE);
+		c = wgetch(stdscr);
+		nodelay(stdscr, FALSE);
+
+		if (c == ERR)
+		{
+			scoutFilterPrompt();
+			scoutPrintFrame();
+			if (scoutWatchWait() != OK)
+				continue;
+			if ((c = wgetch(stdscr)) == ERR)
+				break;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &scout->framestart);
+		scoutLoadCancel(0);
+
+		switch (c)
+		{
+			case KEY_UP:
+			case KEY_DOWN:
+				if (dir->entrycount > 0)
+					scoutMoveLines(c == KEY_UP ? -1 : 1);
+				continue;
+
+			case KEY_BACKSPACE:
+			case 127:
+			case '\b':
+				if (scout->filterlen == 0)
+					continue;
+				scout->filter[--scout->filterlen] = '\0';
+				scoutFilterApply(dir, 0);
+				break;
+
+			case '\n':
+			case KEY_ENTER:
+				done = 1;
+				if (dir->entrycount > 0)
+					continue;
+				/* nothing matched, nothing worth keeping */
+				scoutFilterEnd();
+				break;
+
+			case 27:
+				done = 1;
+				scoutFilterEnd();
+				break;
+
+			default:
+				if (c < 32 || c > 126 || scout->filterlen == NAME_MAX)
+					continue;
+				scout->filter[scout->filterlen++] = (c >= 'A' && c <= 'Z') ? c + 0x20 : c;
+				scout->filter[scout->filterlen] = '\0';
+				scoutFilterApply(dir, 1);
+				break;
+		}
+
+		buf = scout->dir[NEXT];
+		scoutLoadDir(CURR, RELOAD);
+		scoutLoadDir(NEXT, LOAD);
+		scoutPrintInfo();
+		scoutCacheDir(buf);
+		scoutCacheList(&buf);
+		scoutWatchDirs();
+	}
+
+	curs_set(0);
+	scoutPrintInfo();
+	return OK;
 }
 
-int scoutMarkEntry(ENTR **entries, int selentry)
+int scoutFilterApply(SDIR *dir, int narrow)
 {
-	if (entries == NULL)
+	int i, j, k, m, n;
+	int start[256];
+	FJOB *jobs;
+
+	if (scout->filterdir != dir)
+		return ERR;
+
+	/* a longer query looks only at what the shorter one kept, a shorter one
+	 * at what it kept itself, as narrowing only reorders those in place */
+	if (scout->filterlen == 0)
+	{
+		scoutFilterRestore(dir);
+		dir->selentry = dir->firstentry = 0;
+		return OK;
+	}
+	m = narrow ? dir->entrycount : scout->filterkept[scout->filterlen];
+
+	/* not worth a thread for small listings */
+	if ((n = m / filterthreshold) > filterthreads)
+		n = filterthreads;
+	if (n < 1)
+		n = 1;
+
+	jobs = utilsMalloc(sizeof(FJOB) * n);
+	for (i = 0; i < n; i++)
+	{
+		jobs[i].first = (long) m * i / n;
+		jobs[i].last = (long) m * (i + 1) / n;
+	}
+	if (n > 1)
+		scoutRunThreads(scoutFilterWorker, jobs, sizeof(FJOB), n);
+	else
+		scoutFilterWorker(jobs);
+	utilsFree(jobs);
+
+	/* best first by a counting sort on the score, ties keep their order */
+	memset(start, 0, sizeof(start));
+	for (i = 0; i < m; i++)
+		if (scout->fents[i].score >= 0)
+			start[255 - scout->fents[i].score]++;
+	for (i = k = 0; i < 256; i++)
+	{
+		j = start[i];
+		start[i] = k;
+		k += j;
+	}
+	n = k;
+
+	for (i = 0; i < m; i++)
+	{
+		if (scout->fents[i].score < 0)
+			continue;
+		k = start[255 - scout->fents[i].score]++;
+		scout->escratch[k] = dir->entries[i];
+		scout->fscratch[k] = scout->fents[i];
+	}
+
+	/* misses up front take the slots matches left behind, only matches move twice */
+	for (i = 0, j = n; i < n; i++)
+	{
+		if (scout->fents[i].score >= 0)
+			continue;
+		while (scout->fents[j].score < 0)
+			j++;
+		dir->entries[j] = dir->entries[i];
+		scout->fents[j++] = scout->fents[i];
+	}
+	memcpy(dir->entries, scout->escratch, sizeof(ENTR) * n);
+	memcpy(scout->fents, scout->fscratch, sizeof(FENT) * n);
+
+	scout->filterkept[scout->filterlen] = n;
+	dir->entrycount = n;
+	dir->selentry = dir->firstentry = 0;
+	utilsFree(dir->index);
+
+	return OK;
+}
+
+int scoutFilterBegin(SDIR *dir)
+{
+	int i;
+	unsigned int size;
+	FENT *fent;
+
+	/* results still streaming in would slip past the filter */
+	if (dir->entries == NULL || dir->partial || dir->loading || scout->findrun != NULL)
+		return ERR;
+
+	scoutFilterEnd();
+
+	/* back to back in listing order, so the first pass reads straight through */
+	scout->filterblob = utilsMalloc(dir->namesize);
+	scout->fents = utilsMalloc(sizeof(FENT) * dir->entrycount);
+	scout->fscratch = utilsMalloc(sizeof(FENT) * dir->entrycount);
+	scout->escratch = utilsMalloc(sizeof(ENTR) * dir->entrycount);
+
+	for (i = size = 0; i < dir->entrycount; i++)
+	{
+		fent = &scout->fents[i];
+		fent->pos = size;
+		fent->rank = i;
+		size += utilsLower(scout->filterblob + size, ENAME(dir, &dir->entries[i])) + 1;
+		fent->mask = utilsFuzzyMask(scout->filterblob + fent->pos);
+	}
+
+	/* entrytotal tells everyone else this is a view, as the top view does */
+	scout->filterdir = dir;
+	scout->filtercount = dir->entrycount;
+	for (i = 0; i <= NAME_MAX; i++)
+		scout->filterkept[i] = dir->entrycount;
+	scout->filtertotal = dir->entrytotal;
+	if (dir->entrytotal == 0)
+		dir->entrytotal = dir->entrycount;
+
+	return OK;
+}
+
+int scoutFilterEnd(void)
+{
+	int i;
+	unsigned int selname = 0;
+	int selected = 0;
+	SDIR *dir = scout->filterdir;
+
+	if (dir == NULL)
 		return ERR;
 
-	entries[selentry]->ismrk = !entries[selentry]->ismrk;
+	if (dir->entrycount > 0)
+	{
+		selname = dir->entries[dir->selentry].name;
+		selected = 1;
+	}
+
+	scoutFilterRestore(dir);
+	dir->entrytotal = scout->filtertotal;
+
+	dir->selentry = dir->firstentry = 0;
+	for (i = 0; selected && i < dir->entrycount; i++)
+	{
+		if (dir->entries[i].name == selname)
+		{
+			dir->selentry = i;
+			break;
+		}
+	}
+
+	/* counts and du sizes for entries filtered out meanwhile were dropped, so ask again */
+	for (i = 0; i < dir->entrycount; i++)
+	{
+		if (dir->entries[i].flags & ISCNT)
+		{
+			dir->entries[i].flags &= ~ISCNT;
+			scoutSetSize(dir, &dir->entries[i], NULL);
+			dir->entries[i].linekey = 0;
+		}
+	}
+	if (scout->dumode)
+		scoutDuCancel();
+
+	utilsFree(scout->filterblob);
+	utilsFree(scout->fents);
+	utilsFree(scout->fscratch);
+	utilsFree(scout->escratch);
+	scout->filterdir = NULL;
+
+	return OK;
+}
+
+int scoutFilterPrompt(void)
+{
+	int len;
+	char count[32];
+
+	/* the count on the right, the cursor left at the end of the query */
+	wmove(stdscr, LINES - 1, 0);
+	wclrtoeol(stdscr);
+	len = snprintf(count, sizeof(count), "%d/%d", scout->dir[CURR]->entrycount, scout->filtercount);
+	if (len + 1 < COLS)
+		mvwprintw(stdscr, LINES - 1, COLS - len - 1, "%s", count);
+	mvwprintw(stdscr, LINES - 1, 0, "/%s", scout->filter);
+	wnoutrefresh(stdscr);
+
+	return OK;
+}
+
+int scoutFilterRestore(SDIR *dir)
+{
+	int i;
+	FENT *swap;
+
+	/* every entry knows its place in the full listing */
+	for (i = 0; i < scout->filtercount; i++)
+	{
+		scout->escratch[scout->fents[i].rank] = dir->entries[i];
+		scout->fscratch[scout->fents[i].rank] = scout->fents[i];
+	}
+	memcpy(dir->entries, scout->escratch, sizeof(ENTR) * scout->filtercount);
+
+	swap = scout->fents;
+	scout->fents = scout->fscratch;
+	scout->fscratch = swap;
+
+	dir->entrycount = scout->filtercount;
+	utilsFree(dir->index);
+
+	return OK;
+}
+
+void *scoutFilterWorker(void *arg)
+{
+	int i;
+	FENT *fent;
+	FJOB *job = arg;
+	unsigned int mask = utilsFuzzyMask(scout->filter);
+
+	for (i = job->first; i < job->last; i++)
+	{
+		fent = &scout->fents[i];
+		if (scout->filterlen == 0)
+			fent->score = 0;
+		else if (mask & ~fent->mask)
+			fent->score = -1;
+		else
+			fent->score = utilsFuzzyScore(scout->filterblob + fent->pos, scout->filter, scout->filterlen);
+	}
+
+	return arg;
+}
+
+int scoutFind(int grep)
+{
+	int c;
+	int len = 0;
+	char pattern[NAME_MAX + 1];
+
+	pattern[0] = '\0';
+	curs_set(1);
+
+	while (1)
+	{
+		wmove(stdscr, LINES - 1, 0);
+		wclrtoeol(stdscr);
+		mvwprintw(stdscr, LINES - 1, 0, "%s: %s", grep ? "grep" : "find", pattern);
+		wnoutrefresh(stdscr);
+		scoutPrintFrame();
+
+		if ((c = wgetch(stdscr)) == '\n' || c == KEY_ENTER)
+			break;
+
+		if (c == 27 || c == ERR)
+		{
+			len = 0;
+			break;
+		}
+
+		if ((c == KEY_BACKSPACE || c == 127 || c == '\b') && len > 0)
+			pattern[--len] = '\0';
+		else if (c >= 32 && c <= 126 && len < NAME_MAX)
+		{
+			pattern[len++] = c;
+			pattern[len] = '\0';
+		}
+	}
+
+	curs_set(0);
+	if (len == 0 || scoutFindStart(pattern, grep) != OK)
+		scoutPrintInfo();
+
+	return OK;
+}
+
+int scoutFindCancel(void)
+{
+	int finished;
+	FRUN *run;
+
+	if ((run = scout->findrun) == NULL)
+		return ERR;
+
+	/* whoever is last frees it, the walkers stop at their next directory */
+	scout->findrun = NULL;
+	scoutWalkCancel(&run->walk);
+	pthread_mutex_lock(&run->lock);
+	run->owned = 0;
+	finished = run->finished;
+	pthread_mutex_unlock(&run->lock);
+
+	if (finished)
+		scoutFindFree(run);
+
+	return OK;
+}
+
+int scoutFindEnd(void)
+{
+	if (scout->findsaved == NULL)
+		return ERR;
+
+	scoutFindCancel();
+	if (scout->filterdir == scout->dir[CURR])
+		scoutFilterEnd();
+
+	/* the results are never cached, the listing they stood in for comes back */
+	scoutFreeDir(&scout->dir[CURR]);
+	scout->dir[CURR] = scout->findsaved;
+	scout->findsaved = NULL;
+	scout->findgrep = 0;
+
+	/* the order may have changed while the results were up */
+	if (scout->dir[CURR]->sortmode != scout->sortmode || scout->dir[CURR]->sortrev != scout->sortrev)
+		scoutResortDir(scout->dir[CURR]);
+
+	return OK;
+}
+
+int scoutFindEntry(SDIR *dir, char *name)
+{
+	int k;
+	unsigned int i;
+
+	if (dir->entries == NULL)
+		return ERR;
+
+	if (dir->index == NULL)
+		scoutIndexDir(dir);
+
+	for (i = utilsHash(name) & dir->indexmask; (k = dir->index[i]) != ERR; i = (i + 1) & dir->indexmask)
+		if (strcmp(ENAME(dir, &dir->entries[k]), name) == OK)
+			return k;
+
+	return ERR;
+}
+
+int scoutFindFinish(void)
+{
+	int fd = ERR;
+	int i, count, finished;
+	unsigned int name, keylen, selname = 0;
+	ENTR *hits;
+	ENTR *entry;
+	char *names;
+	SDIR *buf;
+	FRUN *run = scout->findrun;
+	SDIR *dir = scout->dir[CURR];
+
+	if (run == NULL)
+		return ERR;
+
+	pthread_mutex_lock(&run->lock);
+	hits = run->hits;
+	names = run->hitnames;
+	count = run->hitcount;
+	run->hits = NULL;
+	run->hitnames = NULL;
+	run->hitcount = run->hitcap = 0;
+	run->hitsize = run->hitnamecap = 0;
+	run->woken = 0;
+	finished = run->finished;
+	pthread_mutex_unlock(&run->lock);
+
+	if (dir->entrycount > 0)
+		selname = dir->entries[dir->selentry].name;
+
+	/* sorted as a batch and merged in, as a streamed listing is */
+	for (i = 0; i < count; i++)
+	{
+		entry = scoutAddEntry(dir, names + hits[i].name);
+		name = entry->name;
+		keylen = entry->keylen;
+		*entry = hits[i];
+		entry->name = name;
+		entry->keylen = keylen;
+
+		/* hit names are relative to the root, so are their link targets */
+		if (entry->flags & ISSYM)
+		{
+			if (fd == ERR)
+				fd = open(dir->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			scoutSetLink(dir, entry, fd);
+		}
+	}
+	if (fd >= 0)
+		close(fd);
+	if (count > 0)
+	{
+		scoutSortEntries(dir, &dir->entries[dir->entrycount - count], count);
+		scoutMergeEntries(dir, dir->entrycount - count);
+	}
+	utilsFree(hits);
+	utilsFree(names);
+
+	if (finished)
+	{
+		scoutFindFree(run);
+		scout->findrun = NULL;
+	}
+
+	/* the preview follows whatever ends up under the cursor */
+	if (count > 0 && (count == dir->entrycount || dir->entries[dir->selentry].name != selname))
+	{
+		buf = scout->dir[NEXT];
+		scoutLoadDir(NEXT, LOAD);
+		scoutCacheDir(buf);
+		scoutCacheList(&buf);
+		scoutWatchDirs();
+	}
+
+	return count > 0 || finished ? OK : ERR;
+}
+
+int scoutFindFree(FRUN *run)
+{
+	int i;
+	FWLK *walker;
+
+	for (i = 0; i < run->walk.count; i++)
+	{
+		walker = (FWLK *) WALKER(&run->walk, i);
+		utilsFree(walker->hits);
+		utilsFree(walker->names);
+		if (run->grep && run->glob)
+			regfree(&walker->regex);
+	}
+
+	scoutWalkFree(&run->walk);
+	close(run->rootfd);
+	pthread_mutex_destroy(&run->lock);
+	utilsFree(run->hits);
+	utilsFree(run->hitnames);
+	utilsFree(run);
+
+	return OK;
+}
+
+int scoutFindHand(FWLK *walker)
+{
+	int i;
+	FRUN *run = (FRUN *) walker->walk.run;
+
+	if (walker->hitcount == 0)
+		return OK;
+
+	/* handed over once per directory, the main loop is woken once per pickup */
+	pthread_mutex_lock(&run->lock);
+	if (run->hitcount + walker->hitcount > run->hitcap)
+	{
+		while (run->hitcount + walker->hitcount > run->hitcap)
+			run->hitcap = run->hitcap ? run->hitcap * 2 : 256;
+		run->hits = utilsRealloc(run->hits, sizeof(ENTR) * run->hitcap);
+	}
+	while (run->hitsize + walker->namesize > run->hitnamecap)
+	{
+		run->hitnamecap = run->hitnamecap ? run->hitnamecap * 2 : 16384;
+		run->hitnames = utilsRealloc(run->hitnames, run->hitnamecap);
+	}
+
+	for (i = 0; i < walker->hitcount; i++)
+	{
+		run->hits[run->hitcount] = walker->hits[i];
+		run->hits[run->hitcount++].name += run->hitsize;
+	}
+	memcpy(run->hitnames + run->hitsize, walker->names, walker->namesize);
+	run->hitsize += walker->namesize;
+
+	if (!run->woken && run->owned && run->wakefd >= 0)
+	{
+		run->woken = 1;
+		write(run->wakefd, "", 1);
+	}
+	pthread_mutex_unlock(&run->lock);
+
+	walker->hitcount = 0;
+	walker->namesize = 0;
+
+	return OK;
+}
+
+ENTR *scoutFindHit(FWLK *walker, char *name, size_t len)
+{
+	ENTR *entry;
+
+	if (walker->hitcount == walker->hitcap)
+	{
+		walker->hitcap = walker->hitcap ? walker->hitcap * 2 : 64;
+		walker->hits = utilsRealloc(walker->hits, sizeof(ENTR) * walker->hitcap);
+	}
+	while (walker->namesize + len + 1 > walker->namecap)
+	{
+		walker->namecap = walker->namecap ? walker->namecap * 2 : 4096;
+		walker->names = utilsRealloc(walker->names, walker->namecap);
+	}
+
+	/* the name is an offset into the walker's blob until it is handed over */
+	entry = &walker->hits[walker->hitcount++];
+	memset(entry, 0, sizeof(ENTR));
+	entry->name = walker->namesize;
+	memcpy(walker->names + walker->namesize, name, len + 1);
+	walker->namesize += len + 1;
+
+	return entry;
+}
+
+int scoutFindMatch(FRUN *run, char *name, char *lower)
+{
+	if (run->glob)
+		return fnmatch(run->pattern, name, run->fold ? FNM_CASEFOLD : 0) == OK ? OK : ERR;
+
+	if (run->fold)
+	{
+		utilsLower(lower, name);
+		name = lower;
+	}
+
+	return strstr(name, run->pattern) != NULL ? OK : ERR;
+}
+
+void *scoutFindRun(void *arg)
+{
+	int owned;
+	FRUN *run = arg;
+
+	scoutRunThreads(scoutWalkWorker, run->walk.walkers, run->walk.size, run->walk.count);
+
+	pthread_mutex_lock(&run->lock);
+	run->finished = 1;
+	if ((owned = run->owned) && run->wakefd >= 0)
+		write(run->wakefd, "", 1);
+	pthread_mutex_unlock(&run->lock);
+
+	if (!owned)
+		scoutFindFree(run);
+
+	return NULL;
+}
+
+int scoutFindStart(char *pattern, int grep)
+{
+	int i, n;
+	char *root;
+	FRUN *run;
+	SDIR *res;
+	SDIR *buf;
+	SDIR *dir;
+	pthread_t thread;
+
+	scoutFilterEnd();
+	clock_gettime(CLOCK_MONOTONIC, &scout->framestart);
+	run = utilsCalloc(1, sizeof(FRUN));
+	if ((run->rootfd = open(scout->dir[CURR]->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+	{
+		utilsFree(run);
+		return ERR;
+	}
+
+	/* smart case as in fd, globs go through fnmatch and the rest is a substring,
+	 * a grep takes the pattern as a regex once it has more than dots to it */
+	strcpy(run->pattern, pattern);
+	run->patternlen = strlen(pattern);
+	run->grep = grep;
+	run->glob = strpbrk(pattern, grep ? "^$*+?()[]{}|\\" : "*?[") != NULL;
+	run->fold = !grep;
+	for (i = 0; pattern[i] != '\0'; i++)
+		if (pattern[i] >= 'A' && pattern[i] <= 'Z')
+			run->fold = 0;
+
+	run->wakefd = scout->loadpipe[1];
+	run->owned = 1;
+	pthread_mutex_init(&run->lock, NULL);
+
+	scoutWalkInit(&run->walk, findthreads, sizeof(FWLK), scoutFindWalk);
+	for (i = 0; run->grep && run->glob && i < run->walk.count; i++)
+		if (regcomp(&((FWLK *) WALKER(&run->walk, i))->regex, pattern, REG_EXTENDED | REG_NEWLINE) != OK)
+			break;
+
+	/* a pattern that does not compile searches nothing, what did compile is let go here */
+	if (run->grep && run->glob && i < run->walk.count)
+	{
+		while (i-- > 0)
+			regfree(&((FWLK *) WALKER(&run->walk, i))->regex);
+		run->glob = 0;
+		scoutFindFree(run);
+		return ERR;
+	}
+
+	/* a grep looks through what is marked, or everything when nothing is */
+	dir = scout->dir[CURR];
+	for (i = n = 0; grep && i < dir->entrycount; i++)
+	{
+		if (!(dir->entries[i].flags & ISMRK))
+			continue;
+		root = utilsMalloc(sizeof(char *) * (strlen(ENAME(dir, &dir->entries[i])) + 1));
+		strcpy(root, ENAME(dir, &dir->entries[i]));
+		scoutWalkPush(WALKER(&run->walk, n++ % run->walk.count), root, 0);
+	}
+
+	if (n == 0)
+	{
+		root = utilsMalloc(sizeof(char *) * 2);
+		strcpy(root, ".");
+		scoutWalkPush(WALKER(&run->walk, 0), root, 0);
+	}
+
+	/* a new search starts from where the last one did */
+	scoutFindEnd();
+	if (scout->dumode)
+		scoutDuCancel();
+
+	/* the results take the place of CURR under the same path, so names relative to it work as paths */
+	res = utilsCalloc(1, sizeof(SDIR));
+	res->sortmode = scout->sortmode;
+	res->sortrev = scout->sortrev;
+	res->path = utilsMalloc(sizeof(char *) * (strlen(scout->dir[CURR]->path) + 1));
+	strcpy(res->path, scout->dir[CURR]->path);
+	scout->findsaved = scout->dir[CURR];
+	scout->dir[CURR] = res;
+	scout->findrun = run;
+	scout->findgrep = grep;
+
+	/* without a loader to wake the main loop, the walk is waited for */
+	if (scout->loadpipe[0] < 0 || pthread_create(&thread, NULL, scoutFindRun, run) != OK)
+	{
+		scoutFindRun(run);
+		scoutFindFinish();
+	}
+	else
+		pthread_detach(thread);
+
+	buf = scout->dir[NEXT];
+	scoutLoadDir(CURR, RELOAD);
+	scoutLoadDir(NEXT, LOAD);
+	scoutPrintInfo();
+	scoutCacheDir(buf);
+	scoutCacheList(&buf);
+	scoutWatchDirs();
+
+	return OK;
+}
+
+int scoutFindWalk(WALK *walk, WITM *item)
+{
+	int fd, j, isdir;
+	long n, i;
+	DENT *d;
+	ENTR hit;
+	ENTR *entry;
+	char *path;
+	size_t len;
+	struct stat st;
+	char lower[NAME_MAX + 1];
+	char sub[PATH_MAX];
+	char *rel = item->path;
+	FWLK *walker = (FWLK *) walk;
+	FRUN *run = (FRUN *) walk->run;
+
+	if ((fd = openat(run->rootfd, rel, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC)) < 0)
+	{
+		/* a marked file is grepped on its own */
+		if (errno == ENOTDIR && run->grep)
+			scoutGrepFile(walker, run->rootfd, rel, rel);
+		return scoutFindHand(walker);
+	}
+
+	while ((n = utilsGetDents(fd, walk->buf, dentbufsize)) > 0)
+	{
+		for (i = 0; i < n; i += d->reclen)
+		{
+			d = (DENT *) (walk->buf + i);
+			if (strcmp(d->name, ".") == OK || strcmp(d->name, "..") == OK)
+				continue;
+
+			/* ignored names are skipped along with everything under them */
+			for (j = 0; j < (int) ARRLENGTH(findignore) && fnmatch(findignore[j], d->name, 0) != OK; j++);
+			if (j < (int) ARRLENGTH(findignore))
+				continue;
+
+			if (rel[0] == '.' && rel[1] == '\0')
+				len = snprintf(sub, sizeof(sub), "%s", d->name);
+			else
+				len = snprintf(sub, sizeof(sub), "%s/%s", rel, d->name);
+			if (len >= sizeof(sub))
+				continue;
+
+			/* only hits are stat'ed, getdents says what else is a directory */
+			if (run->grep)
+			{
+				if (d->type == DT_REG || d->type == DT_UNKNOWN)
+					scoutGrepFile(walker, fd, d->name, sub);
+			}
+			else if (scoutFindMatch(run, d->name, lower) == OK)
+			{
+				memset(&hit, 0, sizeof(ENTR));
+				if (scoutAddFile(&hit, d->name, fd) == OK)
+				{
+					entry = scoutFindHit(walker, sub, len);
+					hit.name = entry->name;
+					*entry = hit;
+				}
+			}
+
+			if (d->type == DT_UNKNOWN)
+				isdir = fstatat(fd, d->name, &st, AT_SYMLINK_NOFOLLOW) == OK && S_ISDIR(st.st_mode);
+			else
+				isdir = d->type == DT_DIR;
+
+			if (isdir)
+			{
+				path = utilsMalloc(sizeof(char *) * (len + 1));
+				memcpy(path, sub, len + 1);
+				scoutWalkPush(walk, path, 0);
+			}
+		}
+	}
+	close(fd);
+
+	return scoutFindHand(walker);
+}
+
+int scoutFreeDir(SDIR **pdir)
+{
+	SDIR *dir;
+
+	if ((dir = *pdir) == NULL)
+		return ERR;
+
+	utilsArenaFree(&dir->arena);
+	utilsFree(dir->entries);
+	utilsFree(dir->names);
+	utilsFree(dir->index);
+	utilsFree(dir->path);
+	utilsFree(dir);
+
+	*pdir = NULL;
+	return OK;
+}
+
+int scoutGetFileInfo(SDIR *dir, ENTR *entry, INFO *info)
+{
+	int i = 0;
+	DATC *date;
+	time_t time, minute;
+	struct tm stime;
+	char user[33];
+	char group[33];
+	char *permsbuf = info->perms;
+
+	/* a symlink whose target could not be stat'ed at load kept its own mode */
+	info->lpath = NULL;
+	if (entry->flags & ISSYM)
+	{
+		permsbuf[i++] = 'l';
+		if ((entry->mode & S_IFMT) != S_IFLNK)
+			info->lpath = entry->link;
+	}
+	else
+	{
+		switch (entry->mode & S_IFMT)
+		{
+			case S_IFREG:
+				permsbuf[i++] = '-';
+				break;
+			case S_IFDIR:
+				permsbuf[i++] = 'd';
+				break;
+			case S_IFLNK:
+				permsbuf[i++] = 'l';
+				break;
+			case S_IFCHR:
+				permsbuf[i++] = 'c';
+				break;
+			case S_IFBLK:
+				permsbuf[i++] = 'b';
+				break;
+			case S_IFSOCK:
+				permsbuf[i++] = 's';
+				break;
+			case S_IFIFO:
+				permsbuf[i++] = 'f';
+				break;
+
+			default:
+				permsbuf[i++] = '-';
+				break;
+		}
+	}
+
+	permsbuf[i++] = entry->mode & S_IRUSR ? 'r' : '-';
+	permsbuf[i++] = entry->mode & S_IWUSR ? 'w' : '-';
+	permsbuf[i++] = entry->mode & S_IXUSR ? 'x' : '-';
+	permsbuf[i++] = entry->mode & S_IRGRP ? 'r' : '-';
+	permsbuf[i++] = entry->mode & S_IWGRP ? 'w' : '-';
+	permsbuf[i++] = entry->mode & S_IXGRP ? 'x' : '-';
+	permsbuf[i++] = entry->mode & S_IROTH ? 'r' : '-';
+	permsbuf[i++] = entry->mode & S_IWOTH ? 'w' : '-';
+	permsbuf[i++] = entry->mode & S_IXOTH ? 'x' : '-';
+	permsbuf[i] = '\0';
+
+	/* numbers stand in until the loader has the names */
+	scoutIdName(entry->uid, 0, user, sizeof(user));
+	scoutIdName(entry->gid, 1, group, sizeof(group));
+	snprintf(info->users, sizeof(info->users), "%s %s", user, group);
+
+	/* localtime only once per minute shown */
+	minute = entry->mtime / 60 - (entry->mtime % 60 < 0);
+	date = &scout->dates[(unsigned long) minute % DSIZE];
+	if (date->str[0] == '\0' || date->minute != minute)
+	{
+		time = minute * 60;
+		localtime_r(&time, &stime);
+		strftime(date->str, sizeof(date->str), "%Y-%m-%d %H:%M", &stime);
+		date->minute = minute;
+	}
+	strcpy(info->dates, date->str);
+
+	return OK;
+}
+
+int scoutGetFileSize(SDIR *dir, ENTR *entry)
+{
+	int i;
+	int dsize;
+	float fsize;
+	char sbuf[60];
+	char sizebuf[64];
+	char path[PATH_MAX];
+	char sizearr[] = "BKMGTPEZY";
+
+	sizebuf[0] = '\0';
+	if (entry->flags & ISSYM)
+		strcat(sizebuf, "-> ");
+
+	/* in du mode directories wait for their recursive size, which prints like a file size */
+	if (scout->dumode && S_ISDIR(entry->mode) && !(entry->flags & (ISSYM | ISDU)))
+	{
+		scoutSetSize(dir, entry, infoCounting);
+		entry->linekey = 0;
+		return OK;
+	}
+
+	switch ((entry->flags & ISDU) ? S_IFREG : entry->mode & S_IFMT)
+	{
+		case S_IFREG:
+			fsize = entry->size;
+			for (i = 0; i < 9 && fsize > 1024.00; i++)
+				fsize /= 1024.00;
+
+			sprintf(sbuf, (i > 0) ? "%.1f %c" : "%.0f %c", fsize, sizearr[i]);
+			strcat(sizebuf, sbuf);
+			break;
+		case S_IFDIR:
+			/* counted by the loader, the column fills in when it is done */
+			if (scoutCountAsync(dir, entry) == OK)
+			{
+				strcat(sizebuf, infoCounting);
+				entry->flags |= ISCNT;
+				break;
+			}
+
+			/* without a loader it is counted here, by its full path */
+			snprintf(path, sizeof(path), dir->path[1] != '\0' ? "%s/%s" : "%s%s", dir->path, ENAME(dir, entry));
+			if ((dsize = scoutCountDir(path)) != ERR)
+			{
+				sprintf(sbuf, "%d", dsize);
+				strcat(sizebuf, sbuf);
+			}
+			else
+			{
+				strcat(sizebuf, "N/A");
+				entry->flags |= NOACC;
+			}
+			break;
+		case S_IFBLK:
+			strcat(sizebuf, "block");
+			break;
+		case S_IFSOCK:
+			strcat(sizebuf, "sock");
+			break;
+		case S_IFIFO:
+			strcat(sizebuf, "fifo");
+			break;
+		case S_IFCHR:
+			strcat(sizebuf, "dev");
+			break;
+
+		default:
+			strcat(sizebuf, "N/A");
+			entry->flags |= NOACC;
+			break;
+	}
+
+	scoutSetSize(dir, entry, sizebuf);
+	entry->linekey = 0;
+	return OK;
+}
+
+int scoutGetFileType(ENTR *entry, char *name)
+{
+	int i;
+	char *ext;
+
+	switch (entry->mode & S_IFMT)
+	{
+		case S_IFDIR:
+			entry->type = CP_DIRECTORY;
+			break;
+		case S_IFSOCK:
+			entry->type = CP_SOCK;
+			break;
+		case S_IFIFO:
+			entry->type = CP_FIFO;
+			break;
+		case S_IFCHR:
+			entry->type = CP_CHR;
+			break;
+		case S_IFBLK:
+			entry->type = CP_BLK;
+			break;
+		case S_IFREG:
+			if ((entry->mode & S_IXUSR) 
+			&& (entry->mode & S_IXOTH) 
+			&& (entry->mode & S_IXGRP))
+			{
+				entry->type = CP_EXECUTABLE;
+				return OK;
+			}
+
+			if ((ext = strrchr(name, '.')) == NULL || *(++ext) == '\0')
+			{
+				entry->type = CP_DEFAULT;
+				return OK;
+			}
+
+			for (i = 0; i < ARRLENGTH(extVideo); i++)
+			{
+				if (strcmp(ext, extVideo[i]) == OK)
+				{
+					entry->type = CP_VIDEO;
+					return OK;
+				}
+			}
+
+			for (i = 0; i < ARRLENGTH(extAudio); i++)
+			{
+				if (strcmp(ext, extAudio[i]) == OK)
+				{
+					entry->type = CP_AUDIO;
+					return OK;
+				}
+			}
+
+			for (i = 0; i < ARRLENGTH(extImage); i++)
+			{
+				if (strcmp(ext, extImage[i]) == OK)
+				{
+					entry->type = CP_IMAGE;
+					return OK;
+				}
+			}
+
+			for (i = 0; i < ARRLENGTH(extArchive); i++)
+			{
+				if (strcmp(ext, extArchive[i]) == OK)
+				{
+					entry->type = CP_ARCHIVE;
+					return OK;
+				}
+			}
+
+			entry->type = CP_DEFAULT;
+			break;
+
+		default: entry->type = CP_DEFAULT;
+	}
+
+	return OK;
+}
+
+int scoutGrepContext(SDIR *next, SDIR *curr, ENTR *hit)
+{
+	int i, k, fd, digits, width;
+	long line, first, n;
+	char *map, *pos, *end, *eol, *colon;
+	ENTR *entry;
+	struct stat st;
+	char path[PATH_MAX];
+	char row[512];
+
+	/* the hit names its file and line */
+	snprintf(path, sizeof(path), "%s", ENAME(curr, hit));
+	if ((colon = strrchr(path, ':')) == NULL)
+		return ERR;
+	*colon = '\0';
+	line = atol(colon + 1);
+
+	next->path = utilsMalloc(sizeof(char *) * (strlen(curr->path) + strlen(path) + 2));
+	sprintf(next->path, curr->path[1] != '\0' ? "%s/%s" : "%s%s", curr->path, path);
+
+	if ((fd = open(next->path, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC)) < 0)
+		return ERR;
+
+	if (fstat(fd, &st) != OK || !S_ISREG(st.st_mode) || st.st_size == 0
+	|| (map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+	{
+		close(fd);
+		return ERR;
+	}
+	close(fd);
+	end = map + st.st_size;
+
+	/* the lines around it are listed as entries, with the hit selected */
+	if ((first = line - scout->lines / 2) < 1)
+		first = 1;
+	for (pos = map, n = 1; n < first && (eol = memchr(pos, '\n', end - pos)) != NULL; n++)
+		pos = eol + 1;
+
+	digits = snprintf(row, sizeof(row), "%ld", first + scout->lines);
+	if ((width = getmaxx(scout->win[NEXT]) - 3) > (int) sizeof(row) - 1)
+		width = sizeof(row) - 1;
+
+	for (i = 0; i < scout->lines && pos < end && width > digits + 1; i++, n++)
+	{
+		if ((eol = memchr(pos, '\n', end - pos)) == NULL)
+			eol = end;
+
+		/* tabs and control characters would throw the columns off */
+		k = snprintf(row, sizeof(row), "%*ld ", digits, n);
+		for (; k < width && pos < eol; pos++)
+			row[k++] = (*pos == '\t' || (unsigned char) *pos < 32 || *pos == 127) ? ' ' : *pos;
+		row[k] = '\0';
+
+		entry = scoutAddEntry(next, row);
+		entry->type = CP_DEFAULT;
+		if (n == line)
+			next->selentry = i;
+		pos = eol < end ? eol + 1 : end;
+	}
+	munmap(map, st.st_size);
+
+	return OK;
+}
+
+int scoutGrepFile(FWLK *walker, int dirfd, char *name, char *rel)
+{
+	int fd;
+	long line = 1;
+	char *map, *pos, *end, *hit, *bol, *eol, *counted;
+	ENTR *entry;
+	size_t len;
+	regmatch_t match;
+	struct stat st;
+	char sub[PATH_MAX + 24];
+	FRUN *run = (FRUN *) walker->walk.run;
+
+	if ((fd = openat(dirfd, name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK | O_CLOEXEC)) < 0)
+		return ERR;
+
+	/* mapped whole, the kernel reads ahead as the search moves through it */
+	if (fstat(fd, &st) != OK || !S_ISREG(st.st_mode) || st.st_size == 0
+	|| (map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+	{
+		close(fd);
+		return ERR;
+	}
+	close(fd);
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+	end = map + st.st_size;
+
+	/* as grep does, a NUL up front marks a binary file, which is skipped */
+	if (memchr(map, '\0', st.st_size < 4096 ? st.st_size : 4096) != NULL)
+		end = map;
+
+	for (pos = counted = map; pos < end && !__atomic_load_n(&run->walk.cancel, __ATOMIC_RELAXED); pos = eol + 1)
+	{
+		/* the whole rest of the file at once, not line by line */
+		if (run->glob)
+		{
+			match.rm_so = 0;
+			match.rm_eo = end - pos;
+			if (regexec(&walker->regex, pos, 1, &match, REG_STARTEND) != OK)
+				break;
+			hit = pos + match.rm_so;
+		}
+		else if ((hit = utilsFindString(pos, end - pos, run->pattern, run->patternlen)) == NULL)
+			break;
+
+		/* one hit per line, numbered by the newlines passed since the last one */
+		if ((bol = memrchr(pos, '\n', hit - pos)) == NULL)
+			bol = pos;
+		else
+			bol++;
+		line += utilsCountByte(counted, bol - counted, '\n');
+		counted = bol;
+
+		len = snprintf(sub, sizeof(sub), "%s:%ld", rel, line);
+		if (len < sizeof(sub))
+		{
+			entry = scoutFindHit(walker, sub, len);
+			scoutSetStat(entry, &st);
+			scoutGetFileType(entry, name);
+		}
+
+		/* a file full of hits streams them in as well */
+		if (walker->hitcount >= 4096)
+			scoutFindHand(walker);
+
+		if ((eol = memchr(hit, '\n', end - hit)) == NULL)
+			break;
+	}
+	munmap(map, st.st_size);
+
+	return OK;
+}
+
+int scoutIdFinish(void)
+{
+	int ready;
+
+	pthread_mutex_lock(&scout->loadlock);
+	ready = scout->idready;
+	scout->idready = 0;
+	pthread_mutex_unlock(&scout->loadlock);
+
+	/* the footer showed the number so far */
+	if (!ready)
+		return ERR;
+
+	scoutPrintInfo();
+	return OK;
+}
+
+int scoutIdName(unsigned int id, int group, char *name, size_t size)
+{
+	IDNM *slot;
+	unsigned int count;
+	int ret = OK;
+
+	if (scout->loadpipe[0] >= 0)
+		pthread_mutex_lock(&scout->loadlock);
+
+	/* first sight of an id, NSS may be a network away so the loader asks it */
+	count = scout->ids.count;
+	slot = scoutIdSlot(id, group);
+	if (scout->ids.count != count)
+	{
+		if (scout->loadpipe[0] >= 0)
+		{
+			scout->idpending++;
+			pthread_cond_broadcast(&scout->loadcond);
+		}
+		else
+		{
+			scoutIdResolve(id, group, slot->name, sizeof(slot->name));
+			slot->ready = 1;
+		}
+	}
+
+	if (slot->ready)
+		snprintf(name, size, "%s", slot->name);
+	else
+	{
+		snprintf(name, size, "%u", id);
+		ret = ERR;
+	}
+
+	if (scout->loadpipe[0] >= 0)
+		pthread_mutex_unlock(&scout->loadlock);
+
+	return ret;
+}
+
+int scoutIdResolve(unsigned int id, int group, char *name, size_t size)
+{
+	int ret;
+	long len;
+	char *buf;
+	struct passwd pw;
+	struct passwd *pwp = NULL;
+	struct group gr;
+	struct group *grp = NULL;
+
+	/* the suggested size is only a hint, large groups need more */
+	if ((len = sysconf(group ? _SC_GETGR_R_SIZE_MAX : _SC_GETPW_R_SIZE_MAX)) <= 0)
+		len = 4096;
+
+	/* the reentrant versions, this runs on the loader */
+	while (1)
+	{
+		buf = utilsMalloc(len);
+		if (group)
+			ret = getgrgid_r(id, &gr, buf, len, &grp);
+		else
+			ret = getpwuid_r(id, &pw, buf, len, &pwp);
+
+		if (ret != ERANGE || len >= 1 << 20)
+			break;
+		utilsFree(buf);
+		len *= 2;
+	}
+
+	if (ret == OK && group && grp != NULL)
+		snprintf(name, size, "%s", grp->gr_name);
+	else if (ret == OK && !group && pwp != NULL)
+		snprintf(name, size, "%s", pwp->pw_name);
+	else
+	{
+		utilsFree(buf);
+		snprintf(name, size, "%u", id);
+		return ERR;
+	}
+
+	utilsFree(buf);
+	return OK;
+}
+
+IDNM *scoutIdSlot(unsigned int id, int group)
+{
+	IDNM key;
+
+	memset(&key, 0, sizeof(IDNM));
+	key.id = id;
+	key.kind = group ? 2 : 1;
+
+	return utilsTableInsert(&scout->ids, &key);
+}
+
+int scoutIndexDir(SDIR *dir)
+{
+	int k;
+	unsigned int i, size;
+
+	utilsFree(dir->index);
+
+	/* open addressing, kept at most half full */
+	for (size = 16; size < (unsigned int) dir->entrycount * 2; size *= 2);
+	dir->index = utilsMalloc(sizeof(int) * size);
+	dir->indexmask = size - 1;
+	memset(dir->index, 0xff, sizeof(int) * size);
+
+	for (k = 0; k < dir->entrycount; k++)
+	{
+		for (i = utilsHash(ENAME(dir, &dir->entries[k])) & dir->indexmask; dir->index[i] != ERR; i = (i + 1) & dir->indexmask);
+		dir->index[i] = k;
+	}
+
+	return OK;
+}
+
+int scoutInitializeCurses(void)
+{
+	int i;
+	int temp;
+
+	if (initscr() == NULL)
+		return ERR;
+	/* something something TODO */
+	cbreak();
+	noecho();
+	curs_set(0);
+	start_color();
+	use_default_colors();
+
+	temp = ARRLENGTH(nColors);
+	for (i = 0; i < temp; i++)
+		init_pair(nColors[i][0], nColors[i][1], nColors[i][2]);
+
+	refresh();
+
+	keypad(stdscr, TRUE);
+
+	return OK;
+}
+
+int scoutLoadAsync(SDIR *dir)
+{
+	if (scout->loadpipe[0] < 0)
+		return ERR;
+
+	/* only the newest request is kept, an older one not yet taken is dropped */
+	pthread_mutex_lock(&scout->loadlock);
+	utilsFree(scout->loadpath);
+	scout->loadpath = utilsMalloc(sizeof(char *) * (strlen(dir->path) + 1));
+	strcpy(scout->loadpath, dir->path);
+	scout->loadsort = dir->sortmode;
+	scout->loadrev = dir->sortrev;
+	__atomic_store_n(&scout->loadgen, scout->loadgen + 1, __ATOMIC_RELAXED);
+	dir->loading = scout->loadgen;
+	dir->partial = 1;
+	pthread_cond_broadcast(&scout->loadcond);
+	pthread_mutex_unlock(&scout->loadlock);
+
+	return OK;
+}
+
+int scoutLoadCancel(int all)
+{
+	if (scout->loadpipe[0] < 0)
+		return ERR;
+
+	/* a prefetch makes way at once, a preview only when all is dropped */
+	pthread_mutex_lock(&scout->loadlock);
+	while (scout->fetchcount > 0)
+		utilsFree(scout->fetch[--scout->fetchcount]);
+	if (all || (scout->loadbusy == 2 && scout->loadpath == NULL))
+		__atomic_store_n(&scout->loadgen, scout->loadgen + 1, __ATOMIC_RELAXED);
+	if (all)
+		scoutFreeDir(&scout->loaded);
+	pthread_cond_broadcast(&scout->loadcond);
+	pthread_mutex_unlock(&scout->loadlock);
+
+	return OK;
+}
+
+int scoutLoadDir(int dir, int mode)
+{
+	int i, j;
+	char *temp;
+	ENTR *selentry;
+
+	switch (dir)
+	{
+		case CURR:
+			if (mode == LOAD || scout->dir[CURR]->partial)
+				scoutReadDir(scout->dir[CURR], 1);
+
+			/* search results stream in whole, and are not walked again */
+			if (scout->topview && scout->dir[CURR]->entrytotal == 0 && scout->findsaved == NULL)
+				scoutTopEntries(scout->dir[CURR], topcount);
+
+			if (scout->dumode && scout->findsaved == NULL)
+			{
+				scoutDuStart(scout->dir[CURR]);
+				scoutDuFinish();
+			}
+
+			scoutPrintRewindList(scout->dir[CURR]);
+
+			for (i = scout->dir[CURR]->firstentry, j = 0; i < scout->dir[CURR]->entrycount && j < scout->lines; i++, j++)
+				if (scout->dir[CURR]->entries[i].sizestr == NULL)
+					scoutGetFileSize(scout->dir[CURR], &scout->dir[CURR]->entries[i]);
+
+			scoutPrintList(scout->dir[CURR], scout->win[CURR]);
+			return OK;
+
+		case NEXT:
+			if (mode == LOAD)
+			{
+				scout->dir[NEXT] = utilsCalloc(1, sizeof(SDIR));
+				scout->dir[NEXT]->sortmode = scout->sortmode;
+				scout->dir[NEXT]->sortrev = scout->sortrev;
+			}
+
+			if (scout->dir[CURR]->entrycount > 0)
+				selentry = &scout->dir[CURR]->entries[scout->dir[CURR]->selentry];
+			else
+				selentry = NULL;
+
+			/* a grep hit shows the lines around it */
+			if (selentry != NULL && scout->findgrep)
+			{
+				if (mode == LOAD)
+					scoutGrepContext(scout->dir[NEXT], scout->dir[CURR], selentry);
+				if (scout->dir[NEXT]->entrycount == 0)
+					return scoutPrintBlank(scout->win[NEXT], NULL, A_NORMAL);
+
+				scoutPrintRewindList(scout->dir[NEXT]);
+				scoutPrintList(scout->dir[NEXT], scout->win[NEXT]);
+				return OK;
+			}
+
+			if (selentry == NULL || selentry->type != CP_DIRECTORY)
+				return scoutPrintBlank(scout->win[NEXT], NULL, A_NORMAL);
+
+			if (selentry->flags & NOACC)
+				return scoutPrintBlank(scout->win[NEXT], errorNoAccess, COLOR_PAIR(CP_ERROR));
+
+			if (mode == LOAD)
+			{
+				scout->dir[NEXT]->path = utilsMalloc(sizeof(char *) * (strlen(scout->dir[CURR]->path) + strlen(ENAME(scout->dir[CURR], selentry)) + 2));
+				if (scout->dir[CURR]->path[1] != '\0')
+					sprintf(scout->dir[NEXT]->path, "%s/%s", scout->dir[CURR]->path, ENAME(scout->dir[CURR], selentry));
+				else
+					sprintf(scout->dir[NEXT]->path, "/%s", ENAME(scout->dir[CURR], selentry));
+
+				/* a listing not at hand is read in the background, a placeholder shows meanwhile */
+				if (scoutCacheLoad(scout->dir[NEXT]) == OK)
+					scoutCacheSearch(scout->dir[NEXT]);
+				else if (scoutLoadAsync(scout->dir[NEXT]) != OK)
+				{
+					scoutReadDir(scout->dir[NEXT], 1);
+					scoutCacheSearch(scout->dir[NEXT]);
+				}
+			}
+
+			scoutPrintRewindList(scout->dir[NEXT]);
+			scoutPrintList(scout->dir[NEXT], scout->win[NEXT]);
+			return OK;
+
+		case PREV:
+			if (mode == LOAD)
+			{
+				scout->dir[PREV] = utilsCalloc(1, sizeof(SDIR));
+				scout->dir[PREV]->sortmode = scout->sortmode;
+				scout->dir[PREV]->sortrev = scout->sortrev;
+			}
+					
+			if (scout->dir[CURR]->path[1] == '\0')
+				return scoutPrintBlank(scout->win[PREV], NULL, A_NORMAL);
+
+			if (mode == LOAD)
+			{
+				i = 0;
+				while (scout->dir[CURR]->path[++i] != '\0');
+				while (scout->dir[CURR]->path[--i] != '/');
+						
+				scout->dir[PREV]->path = utilsMalloc(sizeof(char *) * (i + 2));
+				strncpy(scout->dir[PREV]->path, scout->dir[CURR]->path, i + 1);
+				scout->dir[PREV]->path[i ? i : 1] = '\0';
+				if (scoutCacheLoad(scout->dir[PREV]) != OK)
+					scoutReadDir(scout->dir[PREV], 0);
+
+				if (scoutCacheSearch(scout->dir[PREV]) != OK)
+				{
+					temp = strrchr(scout->dir[CURR]->path, '/') + 1;
+					if ((scout->dir[PREV]->selentry = scoutFindEntry(scout->dir[PREV], temp)) == ERR)
+						scout->dir[PREV]->selentry = 0;
+				}
+			}
+
+			scoutPrintRewindList(scout->dir[PREV]);
+			scoutPrintList(scout->dir[PREV], scout->win[PREV]);
+			return OK;
+		
+		default:
+			return ERR;
+	}
+	return ERR;
+}
+
+int scoutLoadFinish(void)
+{
+	char buf[64];
+	SDIR *dir, *next;
+
+	while (read(scout->loadpipe[0], buf, sizeof(buf)) > 0);
+
+	pthread_mutex_lock(&scout->loadlock);
+	dir = scout->loaded;
+	scout->loaded = NULL;
+	pthread_cond_broadcast(&scout->loadcond);
+	pthread_mutex_unlock(&scout->loadlock);
+
+	if (dir == NULL)
+		return ERR;
+
+	/* a prefetch, or the cursor moved on, but the listing may still come in handy */
+	next = scout->dir[NEXT];
+	if (next == NULL || next->loading == 0 || next->loading != dir->loading || strcmp(next->path, dir->path) != OK)
+	{
+		dir->loading = 0;
+		scoutCacheList(&dir);
+		return ERR;
+	}
+
+	/* the listing moves over, the placeholder is done, read in the order asked for then */
+	dir->loading = 0;
+	utilsFree(next->path);
+	*next = *dir;
+	utilsFree(dir);
+	if (next->sortmode != scout->sortmode || next->sortrev != scout->sortrev)
+		scoutResortDir(next);
+
+	scoutCacheSearch(next);
+	scoutLoadDir(NEXT, RELOAD);
+	scoutPrintInfo();
+	scoutWatchDirs();
+
+	return OK;
+}
+
+int scoutLoadPrefetch(void)
+{
+	int i, j, n;
+	char *path;
+	char *paths[PSIZE];
+	ENTR *entry;
+	SDIR *curr = scout->dir[CURR];
+
+	if (scout->loadpipe[0] < 0 || cachebudget <= 0)
+		return ERR;
+
+	/* wait for the last one to land, or it would look cold and be read again */
+	pthread_mutex_lock(&scout->loadlock);
+	i = scout->loadbusy == 2 || scout->loaded != NULL;
+	pthread_mutex_unlock(&scout->loadlock);
+	if (i)
+		return ERR;
+
+	/* the parent of PREV is taken last, the rows next to the selection first */
+	n = 0;
+	if (scout->dir[PREV] != NULL && scout->dir[PREV]->path != NULL && scout->dir[PREV]->path[1] != '\0')
+	{
+		path = utilsMalloc(sizeof(char *) * (strlen(scout->dir[PREV]->path) + 1));
+		strcpy(path, scout->dir[PREV]->path);
+		*strrchr(path, '/') = '\0';
+		if (path[0] == '\0')
+			strcpy(path, "/");
+		paths[n++] = path;
+	}
+
+	for (i = prefetchrows < PSIZE / 2 ? prefetchrows : PSIZE / 2 - 1; i > 0 && curr->entries != NULL; i--)
+	{
+		for (j = curr->selentry + i; j >= curr->selentry - i; j -= 2 * i)
+		{
+			if (j < 0 || j >= curr->entrycount)
+				continue;
+
+			entry = &curr->entries[j];
+			if (entry->type != CP_DIRECTORY || (entry->flags & NOACC))
+				continue;
+
+			path = utilsMalloc(sizeof(char *) * (strlen(curr->path) + strlen(ENAME(curr, entry)) + 2));
+			if (curr->path[1] != '\0')
+				sprintf(path, "%s/%s", curr->path, ENAME(curr, entry));
+			else
+				sprintf(path, "/%s", ENAME(curr, entry));
+			paths[n++] = path;
+		}
+	}
+
+	if (n == 0)
+		return OK;
+
+	/* the loader weeds out what is warm or too big, the stat calls stay off this thread */
+	pthread_mutex_lock(&scout->loadlock);
+	memcpy(scout->fetch, paths, sizeof(char *) * n);
+	scout->fetchcount = n;
+	scout->loadsort = scout->sortmode;
+	scout->loadrev = scout->sortrev;
+	pthread_cond_broadcast(&scout->loadcond);
+	pthread_mutex_unlock(&scout->loadlock);
+
+	return OK;
+}
+
+int scoutLoadSkip(char *path)
+{
+	int skip;
+	WARM key;
+	WARM *temp;
+	struct stat st;
+
+	/* judged by the size of the directory itself */
+	if (stat(path, &st) != OK || st.st_size > prefetchsize)
+		return OK;
+
+	memset(&key, 0, sizeof(WARM));
+	key.dev = st.st_dev;
+	key.ino = st.st_ino;
+
+	/* a cached listing changed since is read again */
+	pthread_mutex_lock(&scout->loadlock);
+	skip = (temp = utilsTableFind(&scout->warm, &key)) != NULL
+	&& temp->mtime.tv_sec == st.st_mtim.tv_sec && temp->mtime.tv_nsec == st.st_mtim.tv_nsec
+	&& temp->ctime.tv_sec == st.st_ctim.tv_sec && temp->ctime.tv_nsec == st.st_ctim.tv_nsec;
+	pthread_mutex_unlock(&scout->loadlock);
+
+	return skip ? OK : ERR;
+}
+
+void *scoutLoadWorker(void *arg)
+{
+	SDIR *dir;
+	CJOB *job;
+	IDNM *slot;
+	unsigned int k, id;
+	int group, fetch;
+	char name[33];
+	char path[PATH_MAX];
+
+	while (1)
+	{
+		pthread_mutex_lock(&scout->loadlock);
+		while (scout->loadpath == NULL && scout->idpending == 0 && scout->countjobs == NULL && scout->fetchcount == 0)
+			pthread_cond_wait(&scout->loadcond, &scout->loadlock);
+
+		/* the preview goes first, then names and counts, prefetches fill the time in between */
+		if (scout->loadpath == NULL && scout->idpending > 0)
+		{
+			for (k = 0; (slot = utilsTableNext(&scout->ids, &k))->ready;);
+			id = slot->id;
+			group = slot->kind == 2;
+			scout->loadbusy = 4;
+			pthread_mutex_unlock(&scout->loadlock);
+
+			scoutIdResolve(id, group, name, sizeof(name));
+
+			/* the table may have grown meanwhile */
+			pthread_mutex_lock(&scout->loadlock);
+			slot = scoutIdSlot(id, group);
+			strcpy(slot->name, name);
+			slot->ready = 1;
+			scout->idpending--;
+			scout->idready = 1;
+			scout->loadbusy = 0;
+			write(scout->loadpipe[1], "", 1);
+			pthread_cond_broadcast(&scout->loadcond);
+			pthread_mutex_unlock(&scout->loadlock);
+			continue;
+		}
+
+		if (scout->loadpath == NULL && scout->countjobs != NULL)
+		{
+			job = scout->countjobs;
+			scout->countjobs = job->next;
+			scout->loadbusy = 3;
+			pthread_mutex_unlock(&scout->loadlock);
+
+			if (job->path[1] != '\0')
+				snprintf(path, sizeof(path), "%s/%s", job->path, job->name);
+			else
+				snprintf(path, sizeof(path), "/%s", job->name);
+			job->count = scoutCountDir(path);
+
+			pthread_mutex_lock(&scout->loadlock);
+			job->next = scout->countdone;
+			scout->countdone = job;
+			scout->loadbusy = 0;
+			write(scout->loadpipe[1], "", 1);
+			pthread_cond_broadcast(&scout->loadcond);
+			pthread_mutex_unlock(&scout->loadlock);
+			continue;
+		}
+
+		dir = utilsCalloc(1, sizeof(SDIR));
+		if (scout->loadpath != NULL)
+		{
+			dir->path = scout->loadpath;
+			scout->loadpath = NULL;
+			scout->loadbusy = 1;
+			fetch = 0;
+		}
+		else
+		{
+			dir->path = scout->fetch[--scout->fetchcount];
+			scout->loadbusy = 2;
+			fetch = 1;
+		}
+		dir->loading = scout->loadgen;
+		dir->sortmode = scout->loadsort;
+		dir->sortrev = scout->loadrev;
+		pthread_mutex_unlock(&scout->loadlock);
+
+		/* a prefetch of something warm or too big is dropped before it is read */
+		if (!fetch || scoutLoadSkip(dir->path) != OK)
+			scoutReadDir(dir, 0);
+		else
+			dir->partial = 1;
+
+		/* one listing is handed over at a time */
+		pthread_mutex_lock(&scout->loadlock);
+		while (!dir->partial && !STALE(dir) && scout->loaded != NULL)
+			pthread_cond_wait(&scout->loadcond, &scout->loadlock);
+
+		if (dir->partial || STALE(dir))
+			scoutFreeDir(&dir);
+		else
+			scout->loaded = dir;
+
+		/* woken either way, the main loop may want to queue more */
+		scout->loadbusy = 0;
+		write(scout->loadpipe[1], "", 1);
+		pthread_cond_broadcast(&scout->loadcond);
+		pthread_mutex_unlock(&scout->loadlock);
+	}
+
+	return arg;
+}
+
+int scoutMarkEntry(ENTR *entries, int selentry)
+{
+	if (entries == NULL)
+		return ERR;
+
+	entries[selentry].flags ^= ISMRK;
+	return OK;
+}
+
+int scoutMergeEntries(SDIR *dir, int sorted)
+{
+	int i, j, k;
+	ENTR *temp;
+	long selname = -1;
+
+	utilsFree(dir->index);
+	if (sorted == 0 || sorted == dir->entrycount)
+		return OK;
+
+	/* an untouched selection stays on top */
+	if (dir->selentry > 0 && dir->selentry < sorted)
+		selname = dir->entries[dir->selentry].name;
+
+	sortdir = dir;
+	temp = utilsMalloc(sizeof(ENTR) * dir->entrycap);
+	for (i = 0, j = sorted, k = 0; k < dir->entrycount; k++)
+	{
+		if (j == dir->entrycount || (i < sorted && scoutCompareEntries(&dir->entries[i], &dir->entries[j]) <= 0))
+			temp[k] = dir->entries[i++];
+		else
+			temp[k] = dir->entries[j++];
+
+		/* the selection follows its entry, not its index */
+		if (temp[k].name == selname)
+			dir->selentry = k;
+	}
+
+	utilsFree(dir->entries);
+	dir->entries = temp;
+	return OK;
+}
+
+int scoutMove(int dir)
+{
+	int i, deep;
+	char *name;
+	SDIR *buf;
+	switch (dir)
+	{
+		case TOP:
+			if (scout->dir[CURR]->entrycount == 0)
+				return ERR;
+
+			if (scout->dir[CURR]->selentry == 0)
+				return ERR;
+
+			buf = scout->dir[NEXT];
+
+			scout->dir[CURR]->firstentry = scout->dir[CURR]->selentry = 0;
+			
+			scoutLoadDir(CURR, RELOAD);
+			scoutLoadDir(NEXT, LOAD);
+
+			break;
+
+		case BOT:
+			if (scout->dir[CURR]->entrycount == 0)
+				return ERR;
+
+			if (scout->dir[CURR]->selentry == scout->dir[CURR]->entrycount - 1)
+				return ERR;
+
+			buf = scout->dir[NEXT];
+
+			scout->dir[CURR]->firstentry = scout->dir[CURR]->selentry = scout->dir[CURR]->entrycount - 1;
+			for (i = 0; scout->dir[CURR]->firstentry != 0 && i < scout->lines - 1; i++)
+				--scout->dir[CURR]->firstentry;
+			
+			scoutLoadDir(CURR, RELOAD);
+			scoutLoadDir(NEXT, LOAD);
+
+			break;
+
+		case UP:
+			return scoutMoveLines(-1);
+
+		case DOWN:
+			return scoutMoveLines(1);
+
+		case LEFT:
+			if (scout->dir[CURR]->path[1] == '\0')
+				return ERR;
+
+			scoutFilterEnd();
+
+			buf = scout->dir[NEXT];
+
+			/* out of the search results first, back to where it started */
+			if (scoutFindEnd() == OK)
+			{
+				scoutLoadDir(CURR, RELOAD);
+				scoutLoadDir(NEXT, LOAD);
+				break;
+			}
+
+			scout->dir[NEXT] = scout->dir[CURR];
+			scout->dir[CURR] = scout->dir[PREV];
+			scoutLoadDir(CURR, RELOAD);
+			scoutLoadDir(NEXT, RELOAD);
+			scoutLoadDir(PREV, LOAD);
+
+			break;
+
+		case RIGHT:
+			if (scout->dir[CURR]->entrycount == 0)
+				return ERR;
+
+			if (scout->dir[CURR]->entries[scout->dir[CURR]->selentry].type != CP_DIRECTORY)
+				return ERR;
+
+			if (scout->dir[CURR]->entries[scout->dir[CURR]->selentry].flags & NOACC)
+				return ERR;
+
+			scoutFilterEnd();
+
+			/* a hit further down has a parent of its own to show */
+			name = ENAME(scout->dir[CURR], &scout->dir[CURR]->entries[scout->dir[CURR]->selentry]);
+			deep = strchr(name, '/') != NULL;
+			if (scout->findsaved != NULL && !deep)
+			{
+				i = scoutFindEntry(scout->findsaved, name);
+				scout->findsaved->selentry = i != ERR ? i : 0;
+			}
+			if (scoutFindEnd() != OK)
+				deep = 0;
+
+			buf = scout->dir[PREV];
+
+			scout->dir[PREV] = scout->dir[CURR];
+			scout->dir[CURR] = scout->dir[NEXT];
+			if (deep)
+			{
+				scoutCacheDir(scout->dir[PREV]);
+				scoutCacheList(&scout->dir[PREV]);
+				scoutLoadDir(PREV, LOAD);
+			}
+			else
+				scoutLoadDir(PREV, RELOAD);
+			scoutLoadDir(CURR, RELOAD);
+			scoutLoadDir(NEXT, LOAD);
+
+			break;
+
+		default:
+			return ERR;
+	}
+
+	scoutPrintInfo();
+	scoutCacheDir(buf);
+	scoutCacheList(&buf);
+	scoutWatchDirs();
+
+	return OK;
+}
+
+int scoutMoveLines(int n)
+{
+	SDIR *buf;
+	SDIR *curr = scout->dir[CURR];
+
+	if (curr->entrycount == 0)
+		return ERR;
+
+	if (curr->selentry + n < 0)
+		n = -curr->selentry;
+	if (curr->selentry + n > curr->entrycount - 1)
+		n = curr->entrycount - 1 - curr->selentry;
+	if (n == 0)
+		return ERR;
+
+	buf = scout->dir[NEXT];
+
+	/* row by row, the scroll thresholds apply to every step */
+	for (; n < 0; n++)
+	{
+		if (curr->selentry - curr->firstentry <= scout->topthrsh)
+		{
+			if (curr->firstentry != 0)
+				curr->firstentry--;
+		}
+		curr->selentry--;
+	}
+
+	for (; n > 0; n--)
+	{
+		if (curr->selentry - curr->firstentry >= scout->botthrsh)
+		{
+			if (curr->entrycount - curr->selentry > scout->topthrsh + 1)
+				curr->firstentry++;
+		}
+		curr->selentry++;
+	}
+
+	/* only where the cursor ends up is drawn and previewed */
+	scoutLoadDir(CURR, RELOAD);
+	scoutLoadDir(NEXT, LOAD);
+
+	scoutPrintInfo();
+	scoutCacheDir(buf);
+	scoutCacheList(&buf);
+	scoutWatchDirs();
+
+	return OK;
+}
+
+int scoutPrintBlank(WINDOW *win, const char *msg, attr_t attr)
+{
+	int i, k;
+
+	werase(win);
+	if (msg != NULL)
+	{
+		wattrset(win, attr);
+		mvwaddstr(win, 0, 0, msg);
+		wattrset(win, A_NORMAL);
+	}
+	wnoutrefresh(win);
+
+	/* the row cache now holds empty rows, bar the message */
+	for (k = 0; k < 3; k++)
+	{
+		if (scout->win[k] != win || scout->shown[k] == NULL)
+			continue;
+		for (i = 0; i < scout->lines; i++)
+		{
+			scout->shown[k][i * (scout->cols + 1)] = '\0';
+			scout->shownattr[k][i] = A_NORMAL;
+		}
+		if (msg != NULL)
+			scout->shownattr[k][0] = (attr_t) ERR;
+	}
+
+	return OK;
+}
+
+int scoutPrintFrame(void)
+{
+	struct timespec now;
+	long long written;
+
+	if (scout->iofd < 0)
+		return doupdate();
+
+	/* what a keystroke costs: rows redrawn, bytes to the terminal, time since the key */
+	written = scoutPrintWritten();
+	doupdate();
+	written = scoutPrintWritten() - written;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	/* frames nobody typed for are left out, the log itself may be what changed */
+	if (scout->framestart.tv_sec != 0)
+		utilsLogCommit(0, "frame: %d rows, %lld bytes, %ld us", scout->damaged, written,
+			(now.tv_sec - scout->framestart.tv_sec) * 1000000 + (now.tv_nsec - scout->framestart.tv_nsec) / 1000);
+	scout->framestart.tv_sec = 0;
+	scout->damaged = 0;
+
+	return OK;
+}
+
+int scoutPrintInfo(void)
+{
+	int len;
+	INFO info;
+	ENTR *selentry;
+	char count[64];
+
+	/* Cleanup */
+	wmove(stdscr, 0, 0);
+	wclrtoeol(stdscr);
+	wmove(stdscr, LINES - 1, 0);
+	wclrtoeol(stdscr);
+	
+	if (scout->dir[CURR]->entrycount > 0)
+		selentry = &scout->dir[CURR]->entries[scout->dir[CURR]->selentry];
+	else
+		selentry = NULL;
+
+	/* Header */
+	wmove(stdscr, 0, 0);
+	wattron(stdscr, A_BOLD);
+	wattron(stdscr, COLOR_PAIR(CP_HEADERUSER));
+	wprintw(stdscr, "%s@%s ", scout->username, scout->hostname);
+	wattroff(stdscr, COLOR_PAIR(CP_HEADERUSER));
+	wattron(stdscr, COLOR_PAIR(CP_HEADERPATH));
+	wprintw(stdscr, scout->dir[CURR]->path[1] != '\0' ? "%s/" : "%s", scout->dir[CURR]->path);
+	wattroff(stdscr, COLOR_PAIR(CP_HEADERPATH));
+	if (selentry != NULL)
+	{
+		wattron(stdscr, COLOR_PAIR(CP_HEADERFILE));
+		printw("%s", ENAME(scout->dir[CURR], selentry));
+		wattroff(stdscr, COLOR_PAIR(CP_HEADERFILE));
+	}
+	wattroff(stdscr, A_BOLD);
+
+	/* Footer */
+	wmove(stdscr, LINES - 1, 0);
+	if (selentry != NULL 
+	&& scoutGetFileInfo(scout->dir[CURR], selentry, &info) != ERR)
+	{
+		wattron(stdscr, COLOR_PAIR(CP_FOOTERPERM));
+		wprintw(stdscr, "%s ", info.perms);
+		wattroff(stdscr, COLOR_PAIR(CP_FOOTERPERM));
+		wattron(stdscr, COLOR_PAIR(CP_FOOTERUSER));
+		wprintw(stdscr, "%s ", info.users);
+		wattroff(stdscr, COLOR_PAIR(CP_FOOTERUSER));
+		wattron(stdscr, COLOR_PAIR(CP_FOOTERDATE));
+		wprintw(stdscr, "%s ", info.dates);
+		wattroff(stdscr, COLOR_PAIR(CP_FOOTERDATE));
+		if (selentry->flags & ISSYM)
+		{
+			if (info.lpath != NULL)
+			{
+				wattron(stdscr, COLOR_PAIR(CP_FOOTERLINK));
+				wprintw(stdscr, "-> %s", info.lpath);
+				wattroff(stdscr, COLOR_PAIR(CP_FOOTERLINK));
+			}
+			else
+			{
+				wattron(stdscr, COLOR_PAIR(CP_ERROR));
+				wprintw(stdscr, "-> %s", errorSymBroken);
+				wattroff(stdscr, COLOR_PAIR(CP_ERROR));
+			}
+		}
+	}
+
+	/* a search shows how far it got on the right */
+	if (scout->findsaved != NULL)
+	{
+		if (scout->findrun != NULL)
+			len = snprintf(count, sizeof(count), "%s %d", infoSearching, scout->dir[CURR]->entrycount);
+		else
+			len = snprintf(count, sizeof(count), "%d", scout->dir[CURR]->entrycount);
+		if (len + 1 < COLS)
+			mvwprintw(stdscr, LINES - 1, COLS - len - 1, "%s", count);
+	}
+
+	wnoutrefresh(stdscr);
+	return OK;
+}
+
+char *scoutPrintLine(SDIR *dir, ENTR *entry, int len)
+{
+	unsigned short key;
+
+	/* formatted once per width and mark state, not again until the entry changes */
+	key = (len << 2) | ((entry->flags & ISMRK) ? 1 : 0) | ((entry->flags & ISTGD) ? 2 : 0);
+	if (entry->line != NULL && entry->linekey == key)
+		return entry->line;
+
+	if (entry->line == NULL || entry->linecap < len)
+	{
+		entry->line = utilsArenaAlloc(&dir->arena, len);
+		entry->linecap = len;
+	}
+
+	scoutPrintStringizeEntry(dir, entry, entry->line, len, entry->flags & ISMRK, entry->flags & ISTGD);
+	entry->linekey = key;
+
+	return entry->line;
+}
+
+int scoutPrintList(SDIR *dir, WINDOW *win)
+{
+	ENTR *entry;
+	char *string;
+	char *shown;
+	attr_t attr;
+	int i, j, k, len;
+
+	if (dir->loading)
+		return scoutPrintBlank(win, infoLoading, A_NORMAL);
+
+	if (dir->entrycount == 0)
+		return scoutPrintBlank(win, errorDirEmpty, COLOR_PAIR(CP_ERROR));
+
+	if ((len = getmaxx(win)) <= 0)
+		return ERR;
+
+	for (k = 0; k < 3 && scout->win[k] != win; k++);
+
+	/* rows that read and look the same as last time are left alone */
+	for (i = 0, j = dir->firstentry; i < scout->lines; i++, j++)
+	{
+		if (j < dir->entrycount)
+		{
+			entry = &dir->entries[j];
+			string = scoutPrintLine(dir, entry, len);
+
+			attr = COLOR_PAIR(entry->type);
+			if (j == dir->selentry)
+				attr |= A_REVERSE;
+			if ((entry->flags & ISMRK) || entry->type == CP_DIRECTORY || entry->type == CP_EXECUTABLE || entry->type >= 8)
+				attr |= A_BOLD;
+		}
+		else
+		{
+			string = "";
+			attr = A_NORMAL;
+		}
+
+		if (k < 3 && scout->shown[k] != NULL)
+		{
+			shown = scout->shown[k] + i * (scout->cols + 1);
+			if (scout->shownattr[k][i] == attr && !strcmp(shown, string))
+				continue;
+			strcpy(shown, string);
+			scout->shownattr[k][i] = attr;
+		}
+
+		wmove(win, i, 0);
+		wclrtoeol(win);
+		wattrset(win, attr);
+		waddstr(win, string);
+		wattrset(win, A_NORMAL);
+		scout->damaged++;
+	}
+	wnoutrefresh(win);
+
+	return OK;
+}
+
+int scoutPrintRewindList(SDIR *dir)
+{
+	int temp1, temp2;
+
+	if (dir->firstentry != 0)
+		return ERR;
+
+	if (dir->entries == NULL)
+		return ERR;
+
+	if (dir->selentry  >= scout->lines)
+	{
+		temp1 = dir->selentry - scout->lines + 1;
+		temp2 = dir->entrycount - dir->selentry - 1;
+		if (temp2 > scout->topthrsh)
+			dir->firstentry = temp1 + scout->topthrsh;
+		else
+			dir->firstentry = temp1 + temp2;
+	}
+	else if (dir->selentry > scout->botthrsh && dir->entrycount > scout->lines)
+	{
+		temp1 = dir->selentry - scout->botthrsh;
+		temp2 = dir->entrycount - scout->lines;
+		if (temp2 >= temp1)
+			dir->firstentry = temp1;
+		else
+			dir->firstentry = temp2;
+	}
+	else
+		dir->firstentry = 0;
+
+	return OK;
+}
+
+int scoutPrintStringizeEntry(SDIR *dir, ENTR *entry, char *str, int len, int ismrk, int istgd)
+{
+	char *extstr;
+	char *name = ENAME(dir, entry);
+	int res, end, room, stem;
+	int extlen, namelen, sizelen;
+
+	/* tag and mark on the left, the size flush right, the name in between */
+	str[--len] = '\0';
+	memset(str, ' ', len);
+	res = 0;
+
+	if (res < len)
+		str[res++] = istgd ? '*' : ' ';
+	else
+		return ERR;
+
+	if (ismrk && res < len)
+		res++;
+
+	if (res < len)
+		end = len - 1;
+	else
+		return ERR;
+
+	if (entry->sizestr != NULL)
+	{
+		sizelen = strlen(entry->sizestr);
+		if (end - sizelen - res - 2 > 0)
+		{
+			end -= sizelen;
+			memcpy(str + end, entry->sizestr, sizelen);
+			end--;
+		}
+	}
+
+	namelen = strlen(name);
+	if ((room = end - res) >= namelen)
+	{
+		memcpy(str + res, name, namelen);
+		return OK;
+	}
+
+	if (room < 1)
+		return ERR;
+
+	/* names that do not fit lose their tail to a '~', the extension is kept as long as possible */
+	if ((extstr = strrchr(name, '.')) != NULL && extstr != name)
+		extlen = strlen(extstr);
+	else
+		extlen = 0;
+
+	if (extlen > 0 && room - extlen >= 3)
+	{
+		memcpy(str + res, name, room - extlen - 1);
+		str[end - extlen - 1] = '~';
+		memcpy(str + end - extlen, extstr, extlen);
+	}
+	else if (extlen > 0 && room >= 4)
+	{
+		/* the stem keeps up to three columns, the extension gets the rest */
+		if ((stem = namelen - extlen) > 3)
+		{
+			memcpy(str + res, name, 2);
+			str[res + 2] = '~';
+			stem = 3;
+		}
+		else
+			memcpy(str + res, name, stem);
+		memcpy(str + res + stem, extstr, room - stem - 1);
+		str[end - 1] = '~';
+	}
+	else
+	{
+		memcpy(str + res, name, room - 1);
+		str[end - 1] = '~';
+	}
+
+	return OK;
+}
+
+long long scoutPrintWritten(void)
+{
+	char buf[512];
+	char *wchar;
+	ssize_t n;
+
+	/* bytes this thread handed to write(), which is where curses output goes */
+	if ((n = pread(scout->iofd, buf, sizeof(buf) - 1, 0)) <= 0)
+		return 0;
+	buf[n] = '\0';
+
+	if ((wchar = strstr(buf, "wchar:")) == NULL)
+		return 0;
+	return strtoll(wchar + 6, NULL, 10);
+}
+
+int scoutReadBatch(SDIR *dir, int fd, int sorted)
+{
+	int i, j;
+
+	utilsFree(dir->index);
+	scoutStatEntries(&dir->entries[sorted], dir->names, dir->entrycount - sorted, fd);
+
+	/* drop whatever vanished or could not be stat'ed */
+	for (i = j = sorted; i < dir->entrycount; i++)
+		if (dir->entries[i].type != 0)
+			dir->entries[j++] = dir->entries[i];
+
+	/* link targets go in the arena, which only this thread touches */
+	for (i = sorted; i < j; i++)
+		if (dir->entries[i].flags & ISSYM)
+			scoutSetLink(dir, &dir->entries[i], fd);
+
+	if ((dir->entrycount = j) == 0)
+	{
+		utilsFree(dir->entries);
+		dir->entrycap = 0;
+	}
+
+	if (dir->entrycount > sorted)
+	{
+		scoutSortEntries(dir, &dir->entries[sorted], dir->entrycount - sorted);
+		scoutMergeEntries(dir, sorted);
+	}
+
+	return dir->entrycount;
+}
+
+int scoutReadDir(SDIR *dir, int stream)
+{
+	int i;
+	int fd;
+	long n;
+	DENT *d;
+	char *buf;
+	ENTR *entry;
+	char *selentry;
+	int selflag = 0;
+	int sorted, batch, size;
+	struct stat st;
+
+	/* finish what an interrupted read left behind, keeping the selection */
+	if (dir->partial)
+	{
+		if (dir->entries != NULL)
+		{
+			entry = &dir->entries[dir->selentry];
+			selentry = utilsMalloc(sizeof(char *) * (strlen(ENAME(dir, entry)) + 1));
+			strcpy(selentry, ENAME(dir, entry));
+			selflag = 1;
+
+			utilsArenaFree(&dir->arena);
+			utilsFree(dir->entries);
+			utilsFree(dir->names);
+			utilsFree(dir->index);
+			dir->entries = NULL;
+			dir->names = NULL;
+			dir->sizefree = NULL;
+		}
+		dir->entrycount = dir->entrycap = dir->entrytotal = 0;
+		dir->namesize = dir->namecap = dir->namedead = 0;
+		dir->selentry = dir->firstentry = dir->partial = 0;
+		dir->loading = 0;
+	}
+
+	if ((fd = open(dir->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+	{
+		if (selflag)
+			utilsFree(selentry);
+
+		i = 0;
+		while (dir->path[++i] != '\0');
+		while (dir->path[--i] != '/' && i >= 0);
+
+		selentry = utilsMalloc(sizeof(char *) * strlen(&dir->path[i]));
+		strcpy(selentry, &dir->path[i + 1]);
+		dir->path[i ? i : 1] = '\0';
+
+		if ((fd = open(dir->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) < 0)
+		{
+			utilsFree(selentry);
+			return ERR;
+		}
+		else
+			selflag = 1;
+	}
+
+	/* taken before reading, so changes during the read make it stale */
+	if (fstat(fd, &st) == OK)
+	{
+		dir->dev = st.st_dev;
+		dir->ino = st.st_ino;
+		dir->mtime = st.st_mtim;
+		dir->ctime = st.st_ctim;
+	}
+
+	/* without streaming everything is one batch, background reads batch to notice newer requests */
+	if (enablestream && (stream || dir->loading))
+	{
+		batch = streambatch;
+		size = dentbufsize < 32768 ? dentbufsize : 32768;
+	}
+	else
+	{
+		batch = INT_MAX;
+		size = dentbufsize;
+	}
+
+	sorted = 0;
+	buf = utilsMalloc(dentbufsize);
+	while (!dir->partial && (n = utilsGetDents(fd, buf, size)) > 0)
+	{
+		size = dentbufsize;
+		for (i = 0; i < n; i += d->reclen)
+		{
+			d = (DENT *) (buf + i);
+			if (strcmp(d->name, ".") == OK 
+			|| strcmp(d->name, "..") == OK)
+				continue;
+
+			scoutAddEntry(dir, d->name);
+
+			/* batches double in size so merging the runs stays O(n log n) */
+			if (dir->entrycount - sorted >= batch)
+			{
+				sorted = scoutReadBatch(dir, fd, sorted);
+				batch *= 2;
+
+				if (STALE(dir) || (stream && scoutReadPoll(dir) != OK))
+				{
+					dir->partial = 1;
+					break;
+				}
+			}
+		}
+	}
+	utilsFree(buf);
+
+	if (stream || !dir->partial)
+		scoutReadBatch(dir, fd, sorted);
+	close(fd);
+
+	if (selflag == 1)
+	{
+		if ((dir->selentry = scoutFindEntry(dir, selentry)) == ERR)
+			dir->selentry = 0;
+		utilsFree(selentry);
+	}
+
+	/* hand back whatever was typed while the listing streamed in */
+	while (stream && scout->keycount > 0)
+		ungetch(scout->keys[--scout->keycount]);
+
+	return OK;
+}
+
+int scoutReadMoves(int c)
+{
+	int n = 0;
+
+	/* everything already typed is folded into one net move */
+	nodelay(stdscr, TRUE);
+	while (c != ERR)
+	{
+		if (c == 'k' || c == KEY_UP)
+			n--;
+		else if (c == 'j' || c == KEY_DOWN)
+			n++;
+		else
+		{
+			ungetch(c);
+			break;
+		}
+		c = wgetch(stdscr);
+	}
+	nodelay(stdscr, FALSE);
+
+	return n;
+}
+
+int scoutReadPoll(SDIR *dir)
+{
+	int c;
+	int ret = OK;
+	WINDOW *win = NULL;
+
+	/* look the window up every time, SIGWINCH may have rebuilt them,
+	 * a preview being entered is both CURR and still NEXT */
+	for (c = 0; c < 3 && win == NULL; c++)
+		if (scout->dir[c] == dir)
+			win = scout->win[c];
+
+	if (win == NULL)
+		return OK;
+
+	if (dir->entries != NULL)
+	{
+		dir->firstentry = 0;
+		scoutPrintRewindList(dir);
+		scoutPrintList(dir, win);
+	}
+
+	/* once the buffer is full the rest stays queued in curses, behind what is handed back */
+	nodelay(stdscr, TRUE);
+	while (ret == OK && scout->keycount < ARRLENGTH(scout->keys) && (c = wgetch(stdscr)) != ERR)
+	{
+		/* any key makes a preview obsolete */
+		if (dir != scout->dir[CURR] || c == 'q' || c == 'Q')
+		{
+			ungetch(c);
+			ret = ERR;
+			continue;
+		}
+
+		switch (c)
+		{
+			case 'k':
+			case KEY_UP:
+				if (dir->selentry > 0)
+					dir->selentry--;
+				break;
+
+			case 'j':
+			case KEY_DOWN:
+				if (dir->selentry < dir->entrycount - 1)
+					dir->selentry++;
+				break;
+
+			default:
+				scout->keys[scout->keycount++] = c;
+				break;
+		}
+
+		dir->firstentry = 0;
+		scoutPrintRewindList(dir);
+		scoutPrintList(dir, win);
+	}
+	nodelay(stdscr, FALSE);
+
+	return ret;
+}
+
+int scoutResortDir(SDIR *dir)
+{
+	int i;
+	int indexed;
+	unsigned int selname;
+
+	if (dir == NULL)
+		return ERR;
+
+	dir->sortmode = scout->sortmode;
+	dir->sortrev = scout->sortrev;
+	if (dir->entries == NULL)
+		return ERR;
+
+	/* the selection follows its entry, not its index */
+	selname = dir->entries[dir->selentry].name;
+	indexed = dir->index != NULL;
+	scoutSortEntries(dir, dir->entries, dir->entrycount);
+	if (indexed)
+		scoutIndexDir(dir);
+
+	for (i = 0; i < dir->entrycount; i++)
+	{
+		if (dir->entries[i].name == selname)
+		{
+			dir->selentry = i;
+			break;
+		}
+	}
+	dir->firstentry = 0;
+
+	return OK;
+}
+
+int scoutRun(void)
+{
+	int c;
+	int fetched = 0;
+
+	while (running)
+	{
+		/* keys first, changes on disk are applied while waiting for more */
+		nodelay(stdscr, TRUE);
+		c = wgetch(stdscr);
+		nodelay(stdscr, FALSE);
+
+		if (c == ERR)
+		{
+			/* everything drawn since the last pause goes out as one frame */
+			scoutPrintFrame();
+
+			/* once per pause, not again on every wakeup */
+			if (!fetched)
+				fetched = scoutLoadPrefetch() == OK;
+			if (scoutWatchWait() != OK)
+				continue;
+			if ((c = wgetch(stdscr)) == ERR)
+				break;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &scout->framestart);
+
+		/* prefetching makes way for whatever the key asks for */
+		scoutLoadCancel(0);
+		fetched = 0;
+
+		switch(c)
+		{
+			case 'k':
+			case KEY_UP:
+			case 'j':
+			case KEY_DOWN:
+				scoutMoveLines(scoutReadMoves(c));
+				break;
+
+			case 'h':
+			case KEY_LEFT:
+				scoutMove(LEFT);
+				break;
+
+			case 'l':
+			case KEY_RIGHT:
+				scoutMove(RIGHT);
+				break;
+
+			case ' ':
+				scoutMarkEntry(scout->dir[CURR]->entries, scout->dir[CURR]->selentry);
+				if (scoutMove(DOWN) == ERR)
+					scoutLoadDir(CURR, RELOAD);
+				break;
+
+			case 'g':
+				if ((c = wgetch(stdscr)) == 'g')
+					scoutMove(TOP);
+				else
+					; //other
+				break;
+
+			case 'G':
+				scoutMove(BOT);
+				break;
+
+			case 'o':
+				scoutSetSortMode(wgetch(stdscr));
+				break;
+
+			case 'D':
+				scoutDuToggle();
+				break;
+
+
+			case 'a':
+				scoutCommandLine("rename");
+				break;
+
+			case 's':
+				scoutCommandLine("shell");
+				break;
+
+			case '/':
+				scoutFilter();
+				break;
+
+			case 'f':
+				scoutFind(0);
+				break;
+
+			case 'F':
+				scoutFind(1);
+				break;
+
+			case 27:
+				if (scoutFindCancel() == OK)
+					scoutPrintInfo();
+				break;
+
+			case ';':
+			case ':':
+				scoutCommandLine(NULL);
+				break;
+
+			case 'q':
+			case 'Q':
+				running = !running;
+				break;
+
+			case 'r':
+			case 'R':
+				raise(SIGWINCH);
+				break;
+
+			default: break;
+		}
+	}
+
+	return OK;
+}
+
+int scoutRunThreads(void *(*worker)(void *), void *jobs, size_t size, int count)
+{
+	int i, j;
+	pthread_t *threads;
+
+	threads = utilsMalloc(sizeof(pthread_t) * count);
+
+	/* whatever could not get a thread is done right here */
+	for (i = 0; i < count; i++)
+		if (pthread_create(&threads[i], NULL, worker, (char *) jobs + size * i) != OK)
+			break;
+
+	for (j = i; j < count; j++)
+		worker((char *) jobs + size * j);
+
+	while (i-- > 0)
+		pthread_join(threads[i], NULL);
+
+	utilsFree(threads);
+	return OK;
+}
+
+int scoutSetLink(SDIR *dir, ENTR *entry, int dirfd)
+{
+	ssize_t len;
+	char target[PATH_MAX];
+
+	entry->link = NULL;
+	if ((len = readlinkat(dirfd, ENAME(dir, entry), target, sizeof(target) - 1)) < 0)
+		return ERR;
+
+	target[len] = '\0';
+	entry->link = utilsArenaString(&dir->arena, target);
+	return OK;
+}
+
+int scoutSetSize(SDIR *dir, ENTR *entry, const char *str)
+{
+	char *slot;
+
+	/* all size strings take one slot size, so they are rewritten in place and given back for reuse */
+	if (str == NULL)
+	{
+		if (entry->sizestr != NULL)
+		{
+			memcpy(entry->sizestr, &dir->sizefree, sizeof(char *));
+			dir->sizefree = entry->sizestr;
+			entry->sizestr = NULL;
+		}
+		return OK;
+	}
+
+	if ((slot = entry->sizestr) == NULL && (slot = dir->sizefree) != NULL)
+		memcpy(&dir->sizefree, slot, sizeof(char *));
+	else if (slot == NULL)
+		slot = utilsArenaAlloc(&dir->arena, SIZESTR);
+
+	snprintf(slot, SIZESTR, "%.*s", SIZESTR - 1, str);
+	entry->sizestr = slot;
+	return OK;
+}
+
+int scoutSetSortMode(int c)
+{
+	int i;
+
+	switch (c)
+	{
+		case 'n': scout->sortmode = BYNAME; break;
+		case 's': scout->sortmode = BYSIZE; break;
+		case 'm': scout->sortmode = BYTIME; break;
+		case 'e': scout->sortmode = BYEXT; break;
+		case 't': scout->sortmode = BYTYPE; break;
+		case 'r': scout->sortrev = !scout->sortrev; break;
+		case 'S': scout->sortmode = BYSIZE; scout->sortrev = 0; break;
+		case 'M': scout->sortmode = BYTIME; scout->sortrev = 0; break;
+		default: return ERR;
+	}
+	scout->topview = (c == 'S' || c == 'M');
+	scoutFilterEnd();
+
+	/* cached listings are in the old order, and so is anything being read */
+	scoutCacheFlush();
+	scoutLoadCancel(1);
+
+	/* everything needed is already in memory, no rereads, lines around a grep hit stay in order */
+	for (i = PREV; i <= NEXT; i++)
+	{
+		if (i == NEXT && scout->findgrep)
+			continue;
+
+		if (scout->dir[i] != NULL && scout->dir[i]->entrytotal != 0)
+		{
+			scout->dir[i]->entrycount = scout->dir[i]->entrytotal;
+			scout->dir[i]->entrytotal = 0;
+			utilsFree(scout->dir[i]->index);
+		}
+		scoutResortDir(scout->dir[i]);
+	}
+
+	if (scout->dir[NEXT] != NULL && scout->dir[NEXT]->loading)
+		scoutLoadAsync(scout->dir[NEXT]);
+
+	scoutLoadDir(PREV, RELOAD);
+	scoutLoadDir(CURR, RELOAD);
+	scoutLoadDir(NEXT, RELOAD);
+	scoutPrintInfo();
+
+	return OK;
+}
+
+int scoutSetStat(ENTR *entry, struct stat *st)
+{
+	entry->mode = st->st_mode;
+	entry->uid = st->st_uid;
+	entry->gid = st->st_gid;
+	entry->size = st->st_size;
+	entry->mtime = st->st_mtime;
+
+	return OK;
+}
+
+int scoutSetup(char *path)
+{
+	char hostname[64];
+	struct passwd *pw;
+	pthread_t thread;
+	char truepath[PATH_MAX];
+
+	if (enablelog)
+		utilsLogBegin(logfile);
+
+	if (realpath(path, truepath) == NULL)
+		return ERR;
+
+	scout = utilsCalloc(1, sizeof(struct mainstruct));
+	scout->clipboard = utilsCalloc(1, sizeof(CLPB));
+	scout->dir[CURR] = utilsCalloc(1, sizeof(SDIR));
+	scout->dir[CURR]->path = utilsMalloc(sizeof(char *) * (strlen(truepath) + 1));
+	strcpy(scout->dir[CURR]->path, truepath);
+	scout->iofd = (enablelog && logredraw) ? open("/proc/thread-self/io", O_RDONLY | O_CLOEXEC) : ERR;
+
+	pw = getpwuid(geteuid());
+	gethostname(hostname, sizeof(hostname));
+	scout->username = utilsMalloc(sizeof(char *) * (strlen(pw->pw_name) + 1));
+	strcpy(scout->username, pw->pw_name);
+	scout->hostname = utilsMalloc(sizeof(char *) * (strlen(hostname) + 1));
+	strcpy(scout->hostname, hostname);
+
+	scoutInitializeCurses();
+	scoutBuildWindows();
+
+	pthread_mutex_init(&scout->dulock, NULL);
+	pthread_cond_init(&scout->ducond, NULL);
+	utilsTableInit(&scout->counts, sizeof(CNTC), offsetof(CNTC, mtime));
+	utilsTableInit(&scout->du, sizeof(DUCC), offsetof(DUCC, mtime));
+	scout->dusession = time(NULL);
+	utilsTableInit(&scout->ids, sizeof(IDNM), offsetof(IDNM, ready));
+	utilsTableInit(&scout->warm, sizeof(WARM), offsetof(WARM, mtime));
+
+	/* without a loader thread previews are read right away */
+	scout->loadpipe[0] = scout->loadpipe[1] = ERR;
+	if (asyncpreview && pipe2(scout->loadpipe, O_NONBLOCK | O_CLOEXEC) == OK)
+	{
+		pthread_mutex_init(&scout->loadlock, NULL);
+		pthread_cond_init(&scout->loadcond, NULL);
+		if (pthread_create(&thread, NULL, scoutLoadWorker, NULL) == OK)
+			pthread_detach(thread);
+		else
+		{
+			close(scout->loadpipe[0]);
+			close(scout->loadpipe[1]);
+			scout->loadpipe[0] = scout->loadpipe[1] = ERR;
+		}
+	}
+
+	scoutLoadDir(CURR, LOAD);
+	scoutLoadDir(NEXT, LOAD);
+	scoutLoadDir(PREV, LOAD);
+	scoutPrintInfo();
+
+	scout->watch[PREV] = scout->watch[CURR] = scout->watch[NEXT] = ERR;
+	scout->watchfd = livewatch ? inotify_init1(IN_NONBLOCK | IN_CLOEXEC) : ERR;
+	scoutWatchDirs();
+
+	return OK;
+}
+
+int scoutSortEntries(SDIR *dir, ENTR *entries, int count)
+{
+	int i, j, n, step;
+	MJOB *jobs;
+	ENTR *src, *dst, *swap;
+
+	sortdir = dir;
+	utilsFree(dir->index);
+
+	/* not worth a thread for small batches */
+	if ((n = count / sortthreshold) > sortthreads)
+		n = sortthreads;
+
+	if (n < 2)
+	{
+		qsort(entries, count, sizeof(ENTR), scoutCompareEntries);
+		return OK;
+	}
+
+	jobs = utilsMalloc(sizeof(MJOB) * n);
+	for (i = 0; i < n; i++)
+	{
+		jobs[i].src = entries;
+		jobs[i].dst = NULL;
+		jobs[i].dir = dir;
+		jobs[i].first = (long) count * i / n;
+		jobs[i].middle = jobs[i].last = (long) count * (i + 1) / n;
+	}
+	scoutRunThreads(scoutSortWorker, jobs, sizeof(MJOB), n);
+
+	/* merge neighbouring runs pairwise, halving their number every pass */
+	src = entries;
+	dst = utilsMalloc(sizeof(ENTR) * count);
+	for (step = 1; step < n; step *= 2)
+	{
+		for (i = j = 0; i < n; i += 2 * step, j++)
+		{
+			jobs[j].src = src;
+			jobs[j].dst = dst;
+			jobs[j].first = (long) count * i / n;
+			jobs[j].middle = (long) count * (i + step < n ? i + step : n) / n;
+			jobs[j].last = (long) count * (i + 2 * step < n ? i + 2 * step : n) / n;
+		}
+		scoutRunThreads(scoutSortWorker, jobs, sizeof(MJOB), j);
+
+		swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if (src != entries)
+	{
+		memcpy(entries, src, sizeof(ENTR) * count);
+		dst = src;
+	}
+
+	utilsFree(dst);
+	utilsFree(jobs);
 	return OK;
 }
 
-int scoutMove(int dir)
+void *scoutSortWorker(void *arg)
 {
-	int i, j;
-	SDIR *buf;
-	switch (dir)
-	{
-		case TOP:
-			if (scout->dir[CURR]->entries == NULL)
-				return ERR;
-
-			if (scout->dir[CURR]->selentry == 0)
-				return ERR;
+	int i, j, k;
+	MJOB *job = arg;
 
-			buf = scout->dir[NEXT];
+	sortdir = job->dir;
+	if (job->dst == NULL)
+	{
+		qsort(&job->src[job->first], job->last - job->first, sizeof(ENTR), scoutCompareEntries);
+		return NULL;
+	}
 
-			for (i = scout->dir[CURR]->firstentry, j = 0; i < scout->dir[CURR]->entrycount && j < scout->lines; i++, j++)
-				utilsFree(scout->dir[CURR]->entries[i]->size);
+	/* ties go to the left run so equal entries keep their order */
+	for (i = job->first, j = job->middle, k = job->first; k < job->last; k++)
+	{
+		if (j == job->last || (i < job->middle && scoutCompareEntries(&job->src[i], &job->src[j]) <= 0))
+			job->dst[k] = job->src[i++];
+		else
+			job->dst[k] = job->src[j++];
+	}
 
-			scout->dir[CURR]->firstentry = scout->dir[CURR]->selentry = 0;
-			
-			scoutLoadDir(CURR, RELOAD);
-			scoutLoadDir(NEXT, LOAD);
+	return NULL;
+}
 
-			break;
+int scoutStatEntries(ENTR *entries, char *names, int count, int dirfd)
+{
+	int i, n;
+	SJOB *jobs;
 
-		case BOT:
-			if (scout->dir[CURR]->entries == NULL)
-				return ERR;
+	if (useuring && count >= statthreshold)
+	{
+		i = scoutStatRing(entries, names, count, dirfd);
+		entries += i;
+		count -= i;
+	}
 
-			if (scout->dir[CURR]->selentry == scout->dir[CURR]->entrycount - 1)
-				return ERR;
+	/* not worth a thread for small directories */
+	if ((n = count / statthreshold) > statthreads)
+		n = statthreads;
 
-			buf = scout->dir[NEXT];
+	if (n < 2)
+	{
+		SJOB job = {dirfd, 0, count, names, entries};
+		scoutStatWorker(&job);
+		return OK;
+	}
 
-			for (i = scout->dir[CURR]->firstentry, j = 0; i < scout->dir[CURR]->entrycount && j < scout->lines; i++, j++)
-				utilsFree(scout->dir[CURR]->entries[i]->size);
+	jobs = utilsMalloc(sizeof(SJOB) * n);
+	for (i = 0; i < n; i++)
+	{
+		jobs[i].dirfd = dirfd;
+		jobs[i].names = names;
+		jobs[i].entries = entries;
+		jobs[i].first = (long) count * i / n;
+		jobs[i].last = (long) count * (i + 1) / n;
+	}
 
-			scout->dir[CURR]->firstentry = scout->dir[CURR]->selentry = scout->dir[CURR]->entrycount - 1;
-			for (i = 0; scout->dir[CURR]->firstentry != 0 && i < scout->lines - 1; i++)
-				--scout->dir[CURR]->firstentry;
-			
-			scoutLoadDir(CURR, RELOAD);
-			scoutLoadDir(NEXT, LOAD);
+	scoutRunThreads(scoutStatWorker, jobs, sizeof(SJOB), n);
 
-			break;
+	utilsFree(jobs);
+	return OK;
+}
 
-		case UP:
-			if (scout->dir[CURR]->entries == NULL)
-				return ERR;
+int scoutStatRing(ENTR *entries, char *blob, int count, int dirfd)
+{
+	int *res;
+	int *link;
+	char **names;
+	struct stat st;
+	struct statx *sx;
+	int i, j, k, n;
+
+	res = utilsMalloc(sizeof(int) * URINGDEPTH);
+	link = utilsMalloc(sizeof(int) * URINGDEPTH);
+	names = utilsMalloc(sizeof(char *) * URINGDEPTH);
+	sx = utilsMalloc(sizeof(struct statx) * URINGDEPTH);
+
+	for (i = 0; i < count; i += n)
+	{
+		if ((n = count - i) > URINGDEPTH)
+			n = URINGDEPTH;
 
-			if (scout->dir[CURR]->selentry == 0)
-				return ERR;
+		for (j = 0; j < n; j++)
+			names[j] = blob + entries[i + j].name + entries[i + j].keylen;
 
-			buf = scout->dir[NEXT];
+		if (uringStatx(dirfd, names, AT_SYMLINK_NOFOLLOW, sx, res, n) != OK)
+			break;
 
-			if (scout->dir[CURR]->selentry - scout->dir[CURR]->firstentry <= scout->topthrsh)
+		for (j = k = 0; j < n; j++)
+		{
+			/* kernels without IORING_OP_STATX reject it per request */
+			if (res[j] == -EINVAL || res[j] == -EOPNOTSUPP)
+				scoutAddFile(&entries[i + j], names[j], dirfd);
+			else if (res[j] != OK)
+				continue;
+			else if ((sx[j].stx_mode & S_IFMT) == S_IFLNK)
 			{
-				if (scout->dir[CURR]->firstentry != 0)
-				{
-					scout->dir[CURR]->firstentry--;
-					scoutGetFileSize(scout->dir[CURR]->entries[scout->dir[CURR]->firstentry]);
-					utilsFree(scout->dir[CURR]->entries[scout->dir[CURR]->firstentry + scout->lines]->size);
-				}
+				uringStatxToStat(&sx[j], &st);
+				scoutSetStat(&entries[i + j], &st);
+				entries[i + j].flags |= ISSYM;
+				names[k] = names[j];
+				link[k++] = i + j;
 			}
+			else
+			{
+				uringStatxToStat(&sx[j], &st);
+				scoutSetStat(&entries[i + j], &st);
+				scoutGetFileType(&entries[i + j], names[j]);
+			}
+		}
 
-			scout->dir[CURR]->selentry--;
-			scoutLoadDir(CURR, RELOAD);
-			scoutLoadDir(NEXT, LOAD);
-		
-			break;
-
-		case DOWN:
-			if (scout->dir[CURR]->entries == NULL)
-				return ERR;
-
-			if (scout->dir[CURR]->selentry == scout->dir[CURR]->entrycount - 1)
-				return ERR;
-
-			buf = scout->dir[NEXT]; 
+		/* follow the symlinks in one more round, broken ones keep their lstat */
+		if (k > 0 && uringStatx(dirfd, names, 0, sx, res, k) != OK)
+			for (j = 0; j < k; j++)
+				res[j] = ERR;
 
-			if (scout->dir[CURR]->selentry - scout->dir[CURR]->firstentry >= scout->botthrsh)
+		for (j = 0; j < k; j++)
+		{
+			if (res[j] == OK)
 			{
-				if (scout->dir[CURR]->entrycount - scout->dir[CURR]->selentry > scout->topthrsh + 1)
-				{
-					scoutGetFileSize(scout->dir[CURR]->entries[scout->dir[CURR]->firstentry + scout->lines]);
-					utilsFree(scout->dir[CURR]->entries[scout->dir[CURR]->firstentry]->size);
-					scout->dir[CURR]->firstentry++;
-				}
+				uringStatxToStat(&sx[j], &st);
+				scoutSetStat(&entries[link[j]], &st);
 			}
+			scoutGetFileType(&entries[link[j]], names[j]);
+		}
+	}
 
-			scout->dir[CURR]->selentry++;
-			scoutLoadDir(CURR, RELOAD);
-			scoutLoadDir(NEXT, LOAD);
-			
-			break;
+	utilsFree(sx);
+	utilsFree(names);
+	utilsFree(link);
+	utilsFree(res);
 
-		case LEFT:
-			if (scout->dir[CURR]->path[1] == '\0')
-				return ERR;
+	return i;
+}
 
-			buf = scout->dir[NEXT];
+void *scoutStatWorker(void *arg)
+{
+	int i;
+	SJOB *job = arg;
 
-			for (i = scout->dir[CURR]->firstentry, j = 0; i < scout->dir[CURR]->entrycount && j < scout->lines; i++, j++)
-				utilsFree(scout->dir[CURR]->entries[i]->size);
+	/* type stays 0 for entries that fail */
+	for (i = job->first; i < job->last; i++)
+		scoutAddFile(&job->entries[i], job->names + job->entries[i].name + job->entries[i].keylen, job->dirfd);
 
-			scout->dir[NEXT] = scout->dir[CURR];
-			scout->dir[CURR] = scout->dir[PREV];
-			chdir(scout->dir[CURR]->path);
-			scoutLoadDir(CURR, RELOAD);
-			scoutLoadDir(NEXT, RELOAD);
-			scoutLoadDir(PREV, LOAD);
+	return NULL;
+}
 
-			break;
+int scoutTopEntries(SDIR *dir, int count)
+{
+	int i, j, k, lo, hi;
+	unsigned int selname;
+	ENTR pivot, swap;
+	ENTR *entries = dir->entries;
 
-		case RIGHT:
-			if (scout->dir[CURR]->entries == NULL)
-				return ERR;
+	if (entries == NULL || dir->partial)
+		return ERR;
 
-			if (scout->dir[CURR]->entries[scout->dir[CURR]->selentry]->type != CP_DIRECTORY)
-				return ERR;
+	sortdir = dir;
+	utilsFree(dir->index);
+	selname = entries[dir->selentry].name;
 
-			if (scout->dir[CURR]->entries[scout->dir[CURR]->selentry]->isatu != OK)
-				return ERR;
+	/* only files, the size of a directory means nothing here */
+	for (i = k = 0; i < dir->entrycount; i++)
+	{
+		if (entries[i].type != CP_DIRECTORY)
+		{
+			swap = entries[k];
+			entries[k++] = entries[i];
+			entries[i] = swap;
+		}
+	}
 
-			buf = scout->dir[PREV];
+	if (k == 0)
+		return ERR;
 
-			for (i = scout->dir[CURR]->firstentry, j = 0; i < scout->dir[CURR]->entrycount && j < scout->lines; i++, j++)
-				utilsFree(scout->dir[CURR]->entries[i]->size);
+	if (count > k)
+		count = k;
 
-			scout->dir[PREV] = scout->dir[CURR];
-			scout->dir[CURR] = scout->dir[NEXT];
-			chdir(scout->dir[CURR]->path);
-			scoutLoadDir(PREV, RELOAD);
-			scoutLoadDir(CURR, RELOAD);
-			scoutLoadDir(NEXT, LOAD);
+	/* quickselect the best count to the front, only those get sorted */
+	for (lo = 0, hi = k - 1; lo < hi;)
+	{
+		pivot = entries[lo + (hi - lo) / 2];
+		for (i = lo, j = hi; i <= j;)
+		{
+			while (scoutCompareEntries(&entries[i], &pivot) < 0)
+				i++;
+			while (scoutCompareEntries(&entries[j], &pivot) > 0)
+				j--;
+			if (i <= j)
+			{
+				swap = entries[i];
+				entries[i++] = entries[j];
+				entries[j--] = swap;
+			}
+		}
 
+		if (count - 1 <= j)
+			hi = j;
+		else if (count - 1 >= i)
+			lo = i;
+		else
 			break;
-
-		default:
-			return ERR;
 	}
+	qsort(entries, count, sizeof(ENTR), scoutCompareEntries);
 
-	scoutPrintInfo();
-	scoutCacheDir(buf);
-	scoutFreeDir(&buf);
+	dir->entrytotal = dir->entrycount;
+	dir->entrycount = count;
+	dir->selentry = dir->firstentry = 0;
+	for (i = 0; i < count; i++)
+		if (entries[i].name == selname)
+			dir->selentry = i;
 
 	return OK;
 }
 
-int scoutPrintInfo(void)
+void scoutSignalHandler(int sigval)
 {
-	ENTR *selentry;
+	int i;
 
-	/* Cleanup */
-	wmove(stdscr, 0, 0);
-	wclrtoeol(stdscr);
-	wmove(stdscr, LINES - 1, 0);
-	wclrtoeol(stdscr);
-	
-	if (scout->dir[CURR]->entries != NULL)
-		selentry = scout->dir[CURR]->entries[scout->dir[CURR]->selentry];
-	else
-		selentry = NULL;
+	scoutDestroyWindows();
+	scoutBuildWindows();
+	scoutPrintInfo();
+	curs_set(0);
 
-	/* Header */
-	wmove(stdscr, 0, 0);
-	wattron(stdscr, A_BOLD);
-	wattron(stdscr, COLOR_PAIR(CP_HEADERUSER));
-	wprintw(stdscr, "%s@%s ", scout->username, scout->hostname);
-	wattroff(stdscr, COLOR_PAIR(CP_HEADERUSER));
-	wattron(stdscr, COLOR_PAIR(CP_HEADERPATH));
-	wprintw(stdscr, scout->dir[CURR]->path[1] != '\0' ? "%s/" : "%s", scout->dir[CURR]->path);
-	wattroff(stdscr, COLOR_PAIR(CP_HEADERPATH));
-	if (selentry != NULL)
-	{
-		wattron(stdscr, COLOR_PAIR(CP_HEADERFILE));
-		printw(selentry->name);
-		wattroff(stdscr, COLOR_PAIR(CP_HEADERFILE));
-	}
-	wattroff(stdscr, A_BOLD);
+	for (i = 0; i < 3; i++)
+		if (scout->dir[i] != NULL)
+			scout->dir[i]->firstentry = 0;
 
-	/* Footer */
-	wmove(stdscr, LINES - 1, 0);
-	if (selentry != NULL 
-	&& scoutGetFileInfo(selentry) != ERR)
+	scoutLoadDir(CURR, RELOAD);
+	scoutLoadDir(NEXT, RELOAD);
+	scoutLoadDir(PREV, RELOAD);
+	scoutPrintFrame();
+}
+
+void scoutSignalQuit(void)
+{
+	unsigned int i;
+	int exitcode;
+	int abandoned = 0;
+	CJOB *job;
+
+	exitcode = running ? ERR : OK;
+
+	running  = 0;
+
+	/* the loader is told of every listing dropped, so before it is locked out */
+	scoutCacheFlush();
+
+	/* stop the loader and leave it waiting on the lock for good */
+	if (scout->loadpipe[0] >= 0)
 	{
-		wattron(stdscr, COLOR_PAIR(CP_FOOTERPERM));
-		wprintw(stdscr, "%s ", selentry->perms);
-		wattroff(stdscr, COLOR_PAIR(CP_FOOTERPERM));
-		wattron(stdscr, COLOR_PAIR(CP_FOOTERUSER));
-		wprintw(stdscr, "%s ", selentry->users);
-		wattroff(stdscr, COLOR_PAIR(CP_FOOTERUSER));
-		wattron(stdscr, COLOR_PAIR(CP_FOOTERDATE));
-		wprintw(stdscr, "%s ", selentry->dates);
-		wattroff(stdscr, COLOR_PAIR(CP_FOOTERDATE));
-		if (selentry->issym)
+		pthread_mutex_lock(&scout->loadlock);
+		__atomic_store_n(&scout->loadgen, scout->loadgen + 1, __ATOMIC_RELAXED);
+		pthread_cond_broadcast(&scout->loadcond);
+		while (scout->loadbusy == 1 || scout->loadbusy == 2)
+			pthread_cond_wait(&scout->loadcond, &scout->loadlock);
+
+		/* a count or a name lookup can hang on a dead mount, it is left behind with what it uses */
+		abandoned = scout->loadbusy != 0;
+		scoutFreeDir(&scout->loaded);
+		utilsFree(scout->loadpath);
+		while (scout->fetchcount > 0)
+			utilsFree(scout->fetch[--scout->fetchcount]);
+
+		/* queued and finished counts alike are dropped */
+		if (scout->countjobs != NULL)
 		{
-			if (selentry->lpath != NULL)
-			{
-				wattron(stdscr, COLOR_PAIR(CP_FOOTERLINK));
-				wprintw(stdscr, "-> %s", selentry->lpath);
-				wattroff(stdscr, COLOR_PAIR(CP_FOOTERLINK));
-			}
-			else
-			{
-				wattron(stdscr, COLOR_PAIR(CP_ERROR));
-				wprintw(stdscr, "-> %s", errorSymBroken);
-				wattroff(stdscr, COLOR_PAIR(CP_ERROR));
-			}
+			scout->countlast->next = scout->countdone;
+			scout->countdone = scout->countjobs;
+		}
+
+		while ((job = scout->countdone) != NULL)
+		{
+			scout->countdone = job->next;
+			utilsFree(job->path);
+			utilsFree(job->name);
+			utilsFree(job);
 		}
-		utilsFree(selentry->perms);
-		utilsFree(selentry->users);
-		utilsFree(selentry->dates);
-		utilsFree(selentry->lpath);
 	}
+	if (!abandoned)
+		utilsTableFree(&scout->counts);
+	utilsTableFree(&scout->ids);
+	utilsFree(countbuf);
+
+	/* a search touches nothing of ours, it is left to notice on its own */
+	scoutFindCancel();
+	scoutFreeDir(&scout->findsaved);
+
+	/* every walk, cancelled or not, is let finish before the du cache goes to disk */
+	pthread_mutex_lock(&scout->dulock);
+	if (scout->durun != NULL)
+		scoutWalkCancel(&scout->durun->walk);
+	while (scout->duruns > 0)
+		pthread_cond_wait(&scout->ducond, &scout->dulock);
+	if (scout->durun != NULL)
+		scoutDuFree(scout->durun);
+	scoutDuSave();
+	utilsTableFree(&scout->du);
+
+	if (scout->iofd >= 0)
+		close(scout->iofd);
+	utilsLogEnd();
+	scoutDestroyWindows();
+	scoutFreeDir(&scout->dir[PREV]);
+	scoutFreeDir(&scout->dir[CURR]);
+	scoutFreeDir(&scout->dir[NEXT]);
+	utilsTableFree(&scout->warm);
 
-	wrefresh(stdscr);
-	return OK;
+	for (i = 0; scout->cache != NULL && i <= scout->cachemask; i++)
+		if (scout->cache[i].path != NULL)
+			scoutClipBoard(&scout->cache[i].content, NULL, NULL);
+	utilsFree(scout->cache);
+	utilsArenaFree(&scout->cachepaths);
+
+	if (scout->watchfd >= 0)
+		close(scout->watchfd);
+
+	scoutClipBoard(scout->clipboard, NULL, NULL);
+	utilsFree(scout->clipboard);
+	utilsFree(scout->username);
+	utilsFree(scout->hostname);
+	if (!abandoned)
+		utilsFree(scout);
+
+	exit(exitcode);
 }
 
-int scoutPrintList(SDIR *dir, WINDOW *win)
+int scoutWalkCancel(WRUN *run)
 {
-	ENTR *entry;
-	char *string;
-	int i, j, len;
+	/* under the lock, so no walker goes to sleep between its check and the wakeup */
+	pthread_mutex_lock(&run->lock);
+	__atomic_store_n(&run->cancel, 1, __ATOMIC_RELAXED);
+	pthread_cond_broadcast(&run->cond);
+	pthread_mutex_unlock(&run->lock);
 
-	if (dir->entries == NULL)
-	{
-		wclear(win);
-		wattron(win, COLOR_PAIR(CP_ERROR));
-		mvwprintw(win, 0, 0, errorDirEmpty);
-		wattrset(win, COLOR_PAIR(CP_ERROR));
-		wrefresh(win);
-		return OK;
-	}
+	return OK;
+}
 
-	if ((len = getmaxx(win)) <= 0)
-		return ERR;
-	string = utilsMalloc(sizeof(char *) * len);
+int scoutWalkFree(WRUN *run)
+{
+	int i;
+	WALK *walker;
 
-	wclear(win);
-	for (i = 0, j = dir->firstentry; i < scout->lines && j < dir->entrycount; i++, j++)
+	for (i = 0; i < run->count; i++)
 	{
-		entry = dir->entries[j];
-		scoutPrintStringizeEntry(entry, string, len, entry->ismrk, entry->istgd);
-
-		if (j == dir->selentry)
-			wattron(win, A_REVERSE);
-		if (entry->ismrk || entry->type == CP_DIRECTORY || entry->type == CP_EXECUTABLE || entry->type >= 8)
-			wattron(win, A_BOLD);
-
-		wattron(win, COLOR_PAIR(entry->type));
-		mvwprintw(win, i, 0, string);
-		wattrset(win, A_NORMAL);
+		walker = WALKER(run, i);
+		while (walker->first < walker->last)
+			utilsFree(walker->items[walker->first++].path);
+		utilsFree(walker->items);
+		pthread_mutex_destroy(&walker->lock);
 	}
-	wrefresh(win);
-	utilsFree(string);
+
+	pthread_mutex_destroy(&run->lock);
+	pthread_cond_destroy(&run->cond);
+	utilsFree(run->walkers);
 
 	return OK;
 }
 
-int scoutPrintRewindList(SDIR *dir)
+int scoutWalkInit(WRUN *run, int count, size_t size, int (*walk)(WALK *, WITM *))
 {
-	int temp1, temp2;
-
-	if (dir->firstentry != 0)
-		return ERR;
+	int i;
 
-	if (dir->entries == NULL)
-		return ERR;
+	run->count = count > 0 ? count : 1;
+	run->size = size;
+	run->walk = walk;
+	run->walkers = utilsCalloc(run->count, size);
+	pthread_mutex_init(&run->lock, NULL);
+	pthread_cond_init(&run->cond, NULL);
 
-	if (dir->selentry  >= scout->lines)
-	{
-		temp1 = dir->selentry - scout->lines + 1;
-		temp2 = dir->entrycount - dir->selentry - 1;
-		if (temp2 > scout->topthrsh)
-			dir->firstentry = temp1 + scout->topthrsh;
-		else
-			dir->firstentry = temp1 + temp2;
-	}
-	else if (dir->selentry > scout->botthrsh && dir->entrycount > scout->lines)
+	for (i = 0; i < run->count; i++)
 	{
-		temp1 = dir->selentry - scout->botthrsh;
-		temp2 = dir->entrycount - scout->lines;
-		if (temp2 >= temp1)
-			dir->firstentry = temp1;
-		else
-			dir->firstentry = temp2;
-	}
-	else
-		dir->firstentry = 0;
+		pthread_mutex_init(&WALKER(run, i)->lock, NULL);
+		WALKER(run, i)->index = i;
+		WALKER(run, i)->run = run;
+	}
 
 	return OK;
 }
 
-int scoutPrintStringizeEntry(ENTR *entry, char *str, int len, int ismrk, int istgd)
+int scoutWalkPop(WALK *walker, WITM *item)
 {
-	char *extstr;
-	int buf, res, loss;
-	int extlen, namelen, sizelen;
-
-	str[--len] = '\0';
-	res = loss = extlen = sizelen = 0;
-
-	if (res < len)
-		str[res++] = istgd ? '*' : ' ';
-	else
-		return ERR;
+	int i;
+	WRUN *run = walker->run;
 
-	if (res < len)
+	while (!__atomic_load_n(&run->cancel, __ATOMIC_RELAXED))
 	{
-		if (ismrk)
-			str[res++] = ' ';
-	}
-	else
-		return ERR;
+		/* own work first, then anybody else's */
+		for (i = 0; i < run->count; i++)
+			if (scoutWalkTake(WALKER(run, (walker->index + i) % run->count), item, i > 0) == OK)
+				return OK;
 
-	if (res < len)
-		str[--len] = ' ';
-	else
-		return ERR;
-	
-	if (entry->size != NULL)
-	{
-		sizelen = strlen(entry->size);
-		if (len - sizelen - res - 2 > 0)
-		{
-			while (sizelen > 0)
-				str[--len] = entry->size[--sizelen];
-			str[--len] = ' ';
-		}
+		/* then sleep until something is pushed, the last directory is done or the walk is cancelled,
+		 * waiting is raised before queued is read and pushers raise queued before reading waiting */
+		pthread_mutex_lock(&run->lock);
+		__atomic_add_fetch(&run->waiting, 1, __ATOMIC_SEQ_CST);
+		while (__atomic_load_n(&run->queued, __ATOMIC_SEQ_CST) == 0
+		&& __atomic_load_n(&run->outstanding, __ATOMIC_ACQUIRE) > 0
+		&& !__atomic_load_n(&run->cancel, __ATOMIC_RELAXED))
+			pthread_cond_wait(&run->cond, &run->lock);
+		__atomic_sub_fetch(&run->waiting, 1, __ATOMIC_SEQ_CST);
+		pthread_mutex_unlock(&run->lock);
+
+		if (__atomic_load_n(&run->outstanding, __ATOMIC_ACQUIRE) == 0)
+			break;
 	}
 
-	namelen = strlen(entry->name);
-	if ((buf = len - res - namelen) > 0)
-		while (buf-- > 0)
-			str[--len] = ' ';
+	return ERR;
+}
 
-	
-	if ((extstr = strrchr(entry->name, '.')) != NULL && (extstr - entry->name) > 0)
-	{
-		extlen = strlen(extstr);
-		namelen -= extlen;
-		while (extlen > 0)
-		{
-			if (len - extlen - res - 3 >= 0)
-			{
-				if (loss)
-				{
-					str[--len] = '~';
-					--extlen;
-					loss = 0;
-				}
-				while (extlen > 0)
-					str[--len] = extstr[--extlen];
-				break;
-			}
-			else
-			{
-				--extlen;
-				++loss;
-			}
-		}
-	}
+int scoutWalkPush(WALK *walker, char *path, int root)
+{
+	WRUN *run = walker->run;
 
-	if (len - res - 1 < 0)
-		return ERR;
+	__atomic_add_fetch(&run->outstanding, 1, __ATOMIC_RELAXED);
 
-	while (namelen > 0)
+	pthread_mutex_lock(&walker->lock);
+	if (walker->last == walker->cap)
 	{
-		if (len - res - namelen >= 0)
-		{
-			if (loss)
-			{
-				str[--len] = '~';
-				--namelen;
-				loss = 0;
-			}
-			while (namelen > 0)
-				str[--len] = entry->name[--namelen];
-			break;
-		}
-		else
-		{
-			--namelen;
-			++loss;
-		}
+		walker->cap = walker->cap ? walker->cap * 2 : 64;
+		walker->items = utilsRealloc(walker->items, sizeof(WITM) * walker->cap);
+	}
+	walker->items[walker->last].path = path;
+	walker->items[walker->last].root = root;
+	walker->last++;
+	__atomic_add_fetch(&run->queued, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock(&walker->lock);
+
+	/* the lock is only taken when somebody sleeps, see scoutWalkPop */
+	if (__atomic_load_n(&run->waiting, __ATOMIC_SEQ_CST) > 0)
+	{
+		pthread_mutex_lock(&run->lock);
+		pthread_cond_signal(&run->cond);
+		pthread_mutex_unlock(&run->lock);
 	}
 
 	return OK;
 }
 
-int scoutReadDir(SDIR *dir)
+int scoutWalkTake(WALK *walker, WITM *item, int steal)
 {
-	int i;
-	DIR *pdir;
-	ENTR *entry;
-	char *selentry;
-	int selflag = 0;
-	struct dirent *d;
+	int ret = ERR;
 
-	if ((pdir = opendir(dir->path)) == NULL)
+	/* the owner works depth first, thieves take the oldest and biggest subtrees */
+	pthread_mutex_lock(&walker->lock);
+	if (walker->first < walker->last)
 	{
-		i = 0;
-		while (dir->path[++i] != '\0');
-		while (dir->path[--i] != '/' && i >= 0);
+		*item = steal ? walker->items[walker->first++] : walker->items[--walker->last];
+		__atomic_sub_fetch(&walker->run->queued, 1, __ATOMIC_SEQ_CST);
+		ret = OK;
+	}
+	if (walker->first == walker->last)
+		walker->first = walker->last = 0;
+	pthread_mutex_unlock(&walker->lock);
 
-		selentry = utilsMalloc(sizeof(char *) * strlen(&dir->path[i]));
-		strcpy(selentry, &dir->path[i + 1]);
-		dir->path[i ? i : 1] = '\0';
+	return ret;
+}
 
-		if ((pdir = opendir(dir->path)) == NULL)
+void *scoutWalkWorker(void *arg)
+{
+	WITM item;
+	WALK *walker = arg;
+	WRUN *run = walker->run;
+
+	walker->buf = utilsMalloc(dentbufsize);
+	while (scoutWalkPop(walker, &item) == OK)
+	{
+		run->walk(walker, &item);
+		utilsFree(item.path);
+
+		/* children were pushed first, so zero means the whole tree is done */
+		if (__atomic_sub_fetch(&run->outstanding, 1, __ATOMIC_RELEASE) == 0)
 		{
-			utilsFree(selentry);
-			return ERR;
+			pthread_mutex_lock(&run->lock);
+			pthread_cond_broadcast(&run->cond);
+			pthread_mutex_unlock(&run->lock);
 		}
-		else
-			selflag = 1;
 	}
+	utilsFree(walker->buf);
 
-	chdir(dir->path);
-	
-	while ((d = readdir(pdir)) != NULL)
-	{
-		if (strcmp(d->d_name, ".") == OK 
-		|| strcmp(d->d_name, "..") == OK)
-			continue;
+	return NULL;
+}
 
-		if (scoutAddFile(&entry, d->d_name) != OK)
-			continue; // error to log!
+int scoutWatchDirs(void)
+{
+	int i, j;
+	int wd[3];
 
-		dir->entries = utilsRealloc(dir->entries, sizeof(ENTR *) * (dir->entrycount + 1));
-		dir->entries[dir->entrycount++] = entry;
-	}
+	if (scout->watchfd < 0)
+		return ERR;
 
-	if (dir->entries != NULL)
-		qsort(dir->entries, dir->entrycount, sizeof(ENTR *), scoutCompareEntries);
+	/* a directory already watched hands back the same descriptor */
+	for (i = PREV; i <= NEXT; i++)
+	{
+		wd[i] = ERR;
+		if (i == CURR && scout->findsaved != NULL)
+			continue;
+		if (scout->dir[i] != NULL && scout->dir[i]->path != NULL)
+			wd[i] = inotify_add_watch(scout->watchfd, scout->dir[i]->path, WATCHMASK);
+	}
 
-	if (selflag == 1)
+	for (i = PREV; i <= NEXT; i++)
 	{
-		if ((dir->selentry = scoutFindEntry(dir, selentry)) == ERR)
-			dir->selentry = 0;
-		utilsFree(selentry);
+		if (scout->watch[i] < 0)
+			continue;
+		for (j = PREV; j <= NEXT && wd[j] != scout->watch[i]; j++);
+		if (j > NEXT)
+			inotify_rm_watch(scout->watchfd, scout->watch[i]);
 	}
 
-	if (dir != scout->dir[CURR])
-		chdir(scout->dir[CURR]->path);
+	for (i = PREV; i <= NEXT; i++)
+		scout->watch[i] = wd[i];
 
-	closedir(pdir);
 	return OK;
 }
 
-int scoutRun(void)
+int scoutWatchEvents(void)
 {
-	int c;
-	while (running && (c = wgetch(stdscr)) != EOF)
+	SDIR *dir;
+	ENTR *entry;
+	SDIR *buf = NULL;
+	char *events;
+	struct inotify_event *ev;
+	int i, j, k, n, flags;
+	int fds[3], base[3], top[3];
+	int overflow = 0;
+	int filtered = 0;
+	char *selname = NULL;
+	int seltype = 0;
+
+	for (k = PREV; k <= NEXT; k++)
 	{
-		switch(c)
-		{
-			case 'k':
-			case KEY_UP:
-				scoutMove(UP);
-				break;
+		fds[k] = base[k] = ERR;
+		top[k] = 0;
+	}
 
-			case 'j':
-			case KEY_DOWN:
-				scoutMove(DOWN);
-				break;
+	/* by name, offsets do not survive the blob being compacted */
+	if ((dir = scout->dir[CURR])->entrycount > 0)
+	{
+		entry = &dir->entries[dir->selentry];
+		selname = utilsMalloc(sizeof(char *) * (strlen(ENAME(dir, entry)) + 1));
+		strcpy(selname, ENAME(dir, entry));
+		seltype = entry->type;
+	}
 
-			case 'h':
-			case KEY_LEFT:
-				scoutMove(LEFT);
-				break;
+	events = utilsMalloc(65536);
+	while ((n = read(scout->watchfd, events, 65536)) > 0)
+	{
+		for (i = 0; i < n; i += sizeof(struct inotify_event) + ev->len)
+		{
+			ev = (struct inotify_event *) (events + i);
+			if (ev->mask & IN_Q_OVERFLOW)
+				overflow = 1;
 
-			case 'l':
-			case KEY_RIGHT:
-				scoutMove(RIGHT);
-				break;
+			if (ev->len == 0 || overflow)
+				continue;
 
-			case ' ':
-				scoutMarkEntry(scout->dir[CURR]->entries, scout->dir[CURR]->selentry);
-				if (scoutMove(DOWN) == ERR)
-					scoutLoadDir(CURR, RELOAD);
-				break;
+			for (k = PREV; k <= NEXT; k++)
+			{
+				if (scout->watch[k] != ev->wd || (dir = scout->dir[k]) == NULL || dir->partial)
+					continue;
 
-			case 'g':
-				if ((c = wgetch(stdscr)) == 'g')
-					scoutMove(TOP);
+				/* first event for this pane, everything before base is in order */
+				if (base[k] == ERR)
+				{
+					/* a filtered listing is put back whole, and narrowed again once settled */
+					if (dir == scout->filterdir)
+						filtered = scoutFilterEnd() == OK;
+
+					if ((top[k] = dir->entrytotal != 0))
+					{
+						dir->entrycount = dir->entrytotal;
+						dir->entrytotal = 0;
+						utilsFree(dir->index);
+					}
+					base[k] = dir->entrycount;
+					fds[k] = open(dir->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				}
+
+				/* gone entries keep their slot as type 0 until the pane settles */
+				if ((j = scoutFindEntry(dir, ev->name)) != ERR)
+					entry = &dir->entries[j];
+				else if (ev->mask & (IN_CREATE | IN_MOVED_TO))
+					entry = scoutAddEntry(dir, ev->name);
 				else
-					; //other
-				break;
+					continue;
+
+				flags = entry->flags & (ISMRK | ISTGD);
+				entry->type = 0;
+				entry->flags = flags | ISDRT;
+				scoutSetSize(dir, entry, NULL);
+				entry->linekey = 0;
+				entry->link = NULL;
+				if (!(ev->mask & (IN_DELETE | IN_MOVED_FROM))
+				&& scoutAddFile(entry, ev->name, fds[k]) == OK && (entry->flags & ISSYM))
+					scoutSetLink(dir, entry, fds[k]);
+			}
+		}
+	}
+	utilsFree(events);
 
-			case 'G':
-				scoutMove(BOT);
-				break;
+	for (k = PREV; k <= NEXT; k++)
+	{
+		if (base[k] == ERR)
+			continue;
 
+		if (fds[k] >= 0)
+			close(fds[k]);
 
-			case 'a':
-				scoutCommandLine("rename");
-				break;
+		scoutWatchSettle(scout->dir[k], base[k], top[k]);
+		scout->dir[k]->firstentry = 0;
+	}
 
-			case 's':
-				scoutCommandLine("shell");
-				break;
+	/* events were lost, so read the panes again, keeping their state */
+	if (overflow)
+	{
+		for (k = PREV; k <= NEXT; k++)
+		{
+			if ((dir = scout->dir[k]) == NULL || dir->path == NULL || (k == CURR && scout->findsaved != NULL))
+				continue;
 
-			case '/':
-				scoutCommandLine("search");
-				break;
+			if (dir == scout->filterdir)
+				filtered = scoutFilterEnd() == OK;
 
-			case ';':
-			case ':':
-				scoutCommandLine(NULL);
-				break;
+			scoutCacheDir(dir);
+			dir->partial = 1;
+			scoutReadDir(dir, 0);
+			scoutCacheSearch(dir);
+			dir->firstentry = base[k] = 0;
+		}
+	}
 
-			case 'q':
-			case 'Q':
-				running = !running;
-				break;
+	if (filtered && scoutFilterBegin(dir = scout->dir[CURR]) == OK)
+	{
+		scoutFilterApply(dir, 0);
+		for (i = 0; selname != NULL && i < dir->entrycount; i++)
+			if (strcmp(ENAME(dir, &dir->entries[i]), selname) == OK)
+				dir->selentry = i;
+	}
 
-			case 'r':
-			case 'R':
-				raise(SIGWINCH);
-				break;
+	if (base[PREV] != ERR)
+		scoutLoadDir(PREV, RELOAD);
 
-			default: break;
-		}
+	/* walked again, mostly from the du cache, to cover what changed */
+	if (base[CURR] != ERR && scout->dumode)
+		scoutDuCancel();
+
+	if (base[CURR] != ERR)
+		scoutLoadDir(CURR, RELOAD);
+
+	/* a selection that went away or changed type changes the preview */
+	dir = scout->dir[CURR];
+	if (base[CURR] != ERR && (dir->entrycount == 0 || selname == NULL
+	|| strcmp(ENAME(dir, &dir->entries[dir->selentry]), selname) != OK || dir->entries[dir->selentry].type != seltype))
+	{
+		buf = scout->dir[NEXT];
+		scoutLoadDir(NEXT, LOAD);
+		scoutCacheDir(buf);
+		scoutCacheList(&buf);
+		scoutWatchDirs();
 	}
+	else if (base[NEXT] != ERR)
+		scoutLoadDir(NEXT, RELOAD);
 
+	utilsFree(selname);
+	scoutPrintInfo();
 	return OK;
 }
 
-int scoutSetup(char *path)
+int scoutWatchSettle(SDIR *dir, int base, int top)
 {
-	char hostname[64];
-	struct passwd *pw;
-	char truepath[PATH_MAX];
-
-	if (enablelog)
-		utilsLogBegin(logfile);
-
-	if (realpath(path, truepath) == NULL)
-		return ERR;
-
-	scout = utilsCalloc(1, sizeof(struct mainstruct));
-	scout->clipboard = utilsCalloc(1, sizeof(CLPB));
-	scout->dir[CURR] = utilsCalloc(1, sizeof(SDIR));
-	scout->dir[CURR]->path = utilsMalloc(sizeof(char *) * (strlen(truepath) + 1));
-	strcpy(scout->dir[CURR]->path, truepath);
+	int i, j, t;
+	ENTR *tail;
+	unsigned int selname = 0;
+	int selentry = dir->selentry;
 
-	pw = getpwuid(geteuid());
-	gethostname(hostname, sizeof(hostname));
-	scout->username = utilsMalloc(sizeof(char *) * (strlen(pw->pw_name) + 1));
-	strcpy(scout->username, pw->pw_name);
-	scout->hostname = utilsMalloc(sizeof(char *) * (strlen(hostname) + 1));
-	strcpy(scout->hostname, hostname);
+	if (dir->entries != NULL && selentry < dir->entrycount)
+		selname = dir->entries[selentry].name;
 
-	scoutInitializeCurses();
-	scoutBuildWindows();
+	/* untouched entries keep their order, touched and new ones go behind */
+	tail = utilsMalloc(sizeof(ENTR) * (dir->entrycount + 1));
+	for (i = j = t = 0; i < dir->entrycount; i++)
+	{
+		if (dir->entries[i].type == 0)
+		{
+			dir->namedead += EXTLEN(dir, &dir->entries[i]) + 2 + dir->entries[i].keylen + strlen(ENAME(dir, &dir->entries[i])) + 1;
+			continue;
+		}
 
-	scoutLoadDir(CURR, LOAD);
-	scoutLoadDir(NEXT, LOAD);
-	scoutLoadDir(PREV, LOAD);
-	scoutPrintInfo();
+		if (i >= base || (dir->entries[i].flags & ISDRT))
+		{
+			dir->entries[i].flags &= ~ISDRT;
+			tail[t++] = dir->entries[i];
+		}
+		else
+			dir->entries[j++] = dir->entries[i];
+	}
+	memcpy(&dir->entries[j], tail, sizeof(ENTR) * t);
+	utilsFree(tail);
+	utilsFree(dir->index);
 
-	return OK;
-}
+	if ((dir->entrycount = j + t) == 0)
+	{
+		utilsArenaFree(&dir->arena);
+		utilsFree(dir->entries);
+		utilsFree(dir->names);
+		dir->sizefree = NULL;
+		dir->entrycap = 0;
+		dir->namesize = dir->namecap = dir->namedead = 0;
+		dir->selentry = 0;
+		return OK;
+	}
 
-void scoutSignalHandler(int sigval)
-{
-	int i, j;
+	/* churn would grow the blob and the arena for good, and wrap the name offsets */
+	scoutCompactDir(dir, &selname);
 
-	scoutDestroyWindows();
-	scoutBuildWindows();
-	scoutPrintInfo();
-	curs_set(0);
+	if (top)
+	{
+		dir->selentry = 0;
+		for (i = 0; i < dir->entrycount; i++)
+			if (dir->entries[i].name == selname)
+				dir->selentry = i;
+		return scoutTopEntries(dir, topcount);
+	}
 
-	for (i = scout->dir[CURR]->firstentry, j = 0; i < scout->dir[CURR]->entrycount && j < scout->lines; i++, j++)
-		utilsFree(scout->dir[CURR]->entries[i]->size);
+	dir->selentry = 0;
+	scoutSortEntries(dir, &dir->entries[j], t);
+	scoutMergeEntries(dir, j);
 
-	for (i = 0; i < 3; i++)
-		if (scout->dir[i] != NULL)
-			scout->dir[i]->firstentry = 0;
+	/* the selection follows its entry, or stays where it was if it is gone */
+	dir->selentry = selentry < dir->entrycount ? selentry : dir->entrycount - 1;
+	for (i = 0; i < dir->entrycount; i++)
+	{
+		if (dir->entries[i].name == selname)
+		{
+			dir->selentry = i;
+			break;
+		}
+	}
 
-	scoutLoadDir(CURR, RELOAD);
-	scoutLoadDir(NEXT, RELOAD);
-	scoutLoadDir(PREV, RELOAD);
+	return OK;
 }
 
-void scoutSignalQuit(void)
+int scoutWatchWait(void)
 {
-	int i;
-	int exitcode;
-	CACH *temp, *buf;
+	struct pollfd fds[3];
 
-	exitcode = running ? ERR : OK;
+	if (scout->watchfd < 0 && scout->loadpipe[0] < 0)
+		return OK;
 
-	running  = 0;
-	utilsLogEnd();
-	scoutDestroyWindows();
-	scoutFreeDir(&scout->dir[PREV]);
-	scoutFreeDir(&scout->dir[CURR]);
-	scoutFreeDir(&scout->dir[NEXT]);
+	/* poll skips whichever of these is not open */
+	fds[0].fd = STDIN_FILENO;
+	fds[0].events = POLLIN;
+	fds[1].fd = scout->watchfd;
+	fds[1].events = POLLIN;
+	fds[2].fd = scout->loadpipe[0];
+	fds[2].events = POLLIN;
+
+	if (poll(fds, 3, -1) <= 0)
+		return ERR;
 
-	for (i = 0; i < HSIZE; i++)
+	if (fds[2].revents & POLLIN)
 	{
-		temp = scout->cache[i];
-		while (temp != NULL)
+		scoutLoadFinish();
+		scoutIdFinish();
+		scoutCountFinish();
+		if (scoutDuFinish() == OK)
+			scoutLoadDir(CURR, RELOAD);
+		if (scoutFindFinish() == OK)
 		{
-			buf = temp;
-			scoutClipBoard(temp->content, NULL, NULL);
-			utilsFree(temp->content);
-			temp = temp->next;
-			utilsFree(buf);
+			scoutLoadDir(CURR, RELOAD);
+			scoutPrintInfo();
 		}
 	}
 
-	scoutClipBoard(scout->clipboard, NULL, NULL);
-	utilsFree(scout->clipboard);
-	utilsFree(scout->username);
-	utilsFree(scout->hostname);
-	utilsFree(scout);
+	if (fds[1].revents & POLLIN)
+		scoutWatchEvents();
 
-	exit(exitcode);
+	return fds[0].revents ? OK : ERR;
 }
 
 int main(int argc, char *argv[])
@@ -1568,4 +5560,6 @@ int main(int argc, char *argv[])
 	signal(SIGWINCH, scoutSignalHandler);
 	atexit(scoutSignalQuit);
 	scoutRun();
+
+	return EXIT_SUCCESS;
 }
\ No newline at end of file
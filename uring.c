@@ -0,0 +1,224 @@
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "uring.h"
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+
+typedef struct ring
+{
+	int fd;
+	unsigned *sqhead;
+	unsigned *sqtail;
+	unsigned *sqmask;
+	unsigned *sqarray;
+	unsigned *cqhead;
+	unsigned *cqtail;
+	unsigned *cqmask;
+	unsigned entries;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sqptr;
+	void *cqptr;
+	size_t sqlen;
+	size_t cqlen;
+} RING;
+
+static int uringClose(RING *);
+static int uringOpen(RING *, unsigned);
+
+/* set once the kernel (or a seccomp filter) refused to give us a ring, by any thread */
+static int unavailable;
+
+/* one per stating thread, set up on first use and kept until the thread is gone */
+static __thread RING ring;
+
+int uringClose(RING *ring)
+{
+	munmap(ring->sqes, ring->entries * sizeof(struct io_uring_sqe));
+	if (ring->cqptr != ring->sqptr)
+		munmap(ring->cqptr, ring->cqlen);
+	munmap(ring->sqptr, ring->sqlen);
+	close(ring->fd);
+	memset(ring, 0, sizeof(RING));
+
+	return 0;
+}
+
+int uringOpen(RING *ring, unsigned entries)
+{
+	struct io_uring_params p;
+
+	memset(&p, 0, sizeof(p));
+	memset(ring, 0, sizeof(RING));
+
+	if ((ring->fd = syscall(__NR_io_uring_setup, entries, &p)) < 0)
+	{
+		if (errno == ENOSYS || errno == EPERM)
+			__atomic_store_n(&unavailable, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+
+	ring->sqlen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cqlen = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		if (ring->cqlen > ring->sqlen)
+			ring->sqlen = ring->cqlen;
+		ring->cqlen = ring->sqlen;
+	}
+
+	ring->sqptr = mmap(NULL, ring->sqlen, PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+	if (ring->sqptr == MAP_FAILED)
+	{
+		close(ring->fd);
+		return -1;
+	}
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		ring->cqptr = ring->sqptr;
+	else
+	{
+		ring->cqptr = mmap(NULL, ring->cqlen, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+		if (ring->cqptr == MAP_FAILED)
+		{
+			munmap(ring->sqptr, ring->sqlen);
+			close(ring->fd);
+			return -1;
+		}
+	}
+
+	ring->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+	if (ring->sqes == MAP_FAILED)
+	{
+		if (ring->cqptr != ring->sqptr)
+			munmap(ring->cqptr, ring->cqlen);
+		munmap(ring->sqptr, ring->sqlen);
+		close(ring->fd);
+		return -1;
+	}
+
+	ring->sqhead = (unsigned *) ((char *) ring->sqptr + p.sq_off.head);
+	ring->sqtail = (unsigned *) ((char *) ring->sqptr + p.sq_off.tail);
+	ring->sqmask = (unsigned *) ((char *) ring->sqptr + p.sq_off.ring_mask);
+	ring->sqarray = (unsigned *) ((char *) ring->sqptr + p.sq_off.array);
+	ring->cqhead = (unsigned *) ((char *) ring->cqptr + p.cq_off.head);
+	ring->cqtail = (unsigned *) ((char *) ring->cqptr + p.cq_off.tail);
+	ring->cqmask = (unsigned *) ((char *) ring->cqptr + p.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *) ((char *) ring->cqptr + p.cq_off.cqes);
+	ring->entries = p.sq_entries;
+
+	return 0;
+}
+
+/*
+ * Stats count paths relative to dirfd through IORING_OP_STATX, filling
+ * bufs and leaving 0 or -errno per path in res. Returns -1 when
+ * io_uring is not usable, so the caller can fall back to fstatat.
+ */
+int uringStatx(int dirfd, char **paths, int flags, struct statx *bufs, int *res, int count)
+{
+	int i, n, sent, done, ret;
+	unsigned tail, head, idx;
+	struct io_uring_sqe *sqe;
+	struct io_uring_cqe *cqe;
+
+	if (__atomic_load_n(&unavailable, __ATOMIC_RELAXED) || count <= 0)
+		return -1;
+
+	if (ring.entries == 0 && uringOpen(&ring, URINGDEPTH) != 0)
+		return -1;
+
+	for (i = 0; i < count; i += n)
+	{
+		if ((n = count - i) > (int) ring.entries)
+			n = ring.entries;
+
+		tail = *ring.sqtail;
+		for (done = 0; done < n; done++, tail++)
+		{
+			idx = tail & *ring.sqmask;
+			sqe = &ring.sqes[idx];
+			memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = IORING_OP_STATX;
+			sqe->fd = dirfd;
+			sqe->addr = (unsigned long) paths[i + done];
+			sqe->len = STATX_BASIC_STATS;
+			sqe->off = (unsigned long) &bufs[i + done];
+			sqe->statx_flags = flags;
+			sqe->user_data = i + done;
+			ring.sqarray[idx] = idx;
+		}
+		__atomic_store_n(ring.sqtail, tail, __ATOMIC_RELEASE);
+
+		/* submit the whole batch, then reap exactly as many completions */
+		for (sent = done = 0; done < n;)
+		{
+			ret = syscall(__NR_io_uring_enter, ring.fd, n - sent, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+			if (ret >= 0)
+				sent += ret;
+			else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+			{
+				/* requests may be left in flight, the next call starts on a fresh ring */
+				uringClose(&ring);
+				return -1;
+			}
+
+			head = *ring.cqhead;
+			while (head != __atomic_load_n(ring.cqtail, __ATOMIC_ACQUIRE))
+			{
+				cqe = &ring.cqes[head & *ring.cqmask];
+				res[cqe->user_data] = cqe->res;
+				head++;
+				done++;
+			}
+			__atomic_store_n(ring.cqhead, head, __ATOMIC_RELEASE);
+		}
+	}
+
+	return 0;
+}
+
+void uringStatxToStat(struct statx *sx, struct stat *st)
+{
+	memset(st, 0, sizeof(struct stat));
+	st->st_dev = makedev(sx->stx_dev_major, sx->stx_dev_minor);
+	st->st_ino = sx->stx_ino;
+	st->st_mode = sx->stx_mode;
+	st->st_nlink = sx->stx_nlink;
+	st->st_uid = sx->stx_uid;
+	st->st_gid = sx->stx_gid;
+	st->st_rdev = makedev(sx->stx_rdev_major, sx->stx_rdev_minor);
+	st->st_size = sx->stx_size;
+	st->st_blksize = sx->stx_blksize;
+	st->st_blocks = sx->stx_blocks;
+	st->st_atim.tv_sec = sx->stx_atime.tv_sec;
+	st->st_atim.tv_nsec = sx->stx_atime.tv_nsec;
+	st->st_mtim.tv_sec = sx->stx_mtime.tv_sec;
+	st->st_mtim.tv_nsec = sx->stx_mtime.tv_nsec;
+	st->st_ctim.tv_sec = sx->stx_ctime.tv_sec;
+	st->st_ctim.tv_nsec = sx->stx_ctime.tv_nsec;
+}
+
+#else
+
+int uringStatx(int dirfd, char **paths, int flags, struct statx *bufs, int *res, int count)
+{
+	return -1;
+}
+
+void uringStatxToStat(struct statx *sx, struct stat *st)
+{
+}
+
+#endif
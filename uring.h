@@ -0,0 +1,4 @@
+#define URINGDEPTH 4096
+
+int uringStatx(int, char **, int, struct statx *, int *, int);
+void uringStatxToStat(struct statx *, struct stat *);
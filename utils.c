@@ -1,12 +1,75 @@
+#include <sys/syscall.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <ctype.h>
 #include <time.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "utils.h"
 
 static FILE *logfile;
 
+void *utilsArenaAlloc(ARNA *arena, size_t size)
+{
+	CHNK *chunk;
+	size_t csize;
+	uintptr_t p;
+
+	if ((chunk = arena->chunk) != NULL)
+	{
+		p = ((uintptr_t) (chunk->data + chunk->used) + 15) & ~(uintptr_t) 15;
+		if (p + size <= (uintptr_t) (chunk->data + chunk->size))
+		{
+			chunk->used = p + size - (uintptr_t) chunk->data;
+			return (void *) p;
+		}
+	}
+
+	/* chunks double up to CHUNKMAX so big directories need few of them */
+	csize = chunk != NULL ? chunk->size * 2 : CHUNKMIN;
+	if (csize > CHUNKMAX)
+		csize = CHUNKMAX;
+	if (csize < size + 16)
+		csize = size + 16;
+
+	chunk = utilsMalloc(sizeof(CHNK) + csize);
+	chunk->size = csize;
+	chunk->next = arena->chunk;
+	arena->chunk = chunk;
+	arena->total += sizeof(CHNK) + csize;
+
+	p = ((uintptr_t) chunk->data + 15) & ~(uintptr_t) 15;
+	chunk->used = p + size - (uintptr_t) chunk->data;
+	return (void *) p;
+}
+
+void utilsArenaFree(ARNA *arena)
+{
+	CHNK *chunk;
+
+	while ((chunk = arena->chunk) != NULL)
+	{
+		arena->chunk = chunk->next;
+		free(chunk);
+	}
+	arena->total = 0;
+}
+
+char *utilsArenaString(ARNA *arena, const char *str)
+{
+	char *p;
+	size_t len = strlen(str) + 1;
+
+	p = utilsArenaAlloc(arena, len);
+	memcpy(p, str, len);
+	return p;
+}
+
 void utilsFreeC(void **ptr)
 {
 	if (ptr && *ptr)
@@ -46,14 +109,308 @@ void *utilsRealloc(void *oldptr, size_t size)
 	return p;
 }
 
-unsigned int utilsCalcHash(char *str)
+/* FNV-1a over the whole string */
+unsigned int utilsHash(char *str)
+{
+	unsigned int hashval;
+
+	for (hashval = 2166136261u; *str != '\0'; str++)
+		hashval = (hashval ^ (unsigned char) *str) * 16777619u;
+
+	return hashval;
+}
+
+static unsigned int utilsTableHash(HTAB *table, const void *key)
 {
+	size_t i;
 	unsigned int hashval;
 
-	for (hashval = 0; *str != '\0'; str++)
-		hashval = *str + 31 * hashval;
+	for (hashval = 2166136261u, i = 0; i < table->keysize; i++)
+		hashval = (hashval ^ ((const unsigned char *) key)[i]) * 16777619u;
+
+	return hashval;
+}
+
+static int utilsTableUsed(HTAB *table, const char *slot)
+{
+	size_t i;
+
+	for (i = 0; i < table->keysize; i++)
+		if (slot[i] != 0)
+			return 1;
+
+	return 0;
+}
+
+void *utilsTableFind(HTAB *table, const void *key)
+{
+	char *slot;
+	unsigned int i;
+
+	if (table->slots == NULL)
+		return NULL;
+
+	for (i = utilsTableHash(table, key) & table->mask; utilsTableUsed(table, slot = table->slots + i * table->slotsize); i = (i + 1) & table->mask)
+		if (memcmp(slot, key, table->keysize) == 0)
+			return slot;
+
+	return NULL;
+}
+
+void utilsTableFree(HTAB *table)
+{
+	utilsFree(table->slots);
+	table->mask = table->count = 0;
+}
+
+void utilsTableInit(HTAB *table, size_t slotsize, size_t keysize)
+{
+	table->slots = NULL;
+	table->slotsize = slotsize;
+	table->keysize = keysize;
+	table->mask = table->count = 0;
+}
+
+void *utilsTableInsert(HTAB *table, const void *key)
+{
+	char *slot;
+	char *old;
+	unsigned int i, j, size;
+
+	if ((slot = utilsTableFind(table, key)) != NULL)
+		return slot;
+
+	/* grow before half of the slots are taken, probes stay short */
+	size = table->slots != NULL ? table->mask + 1 : 0;
+	if ((table->count + 1) * 2 > size)
+	{
+		old = table->slots;
+		table->slots = utilsCalloc(size ? size * 2 : 64, table->slotsize);
+		table->mask = (size ? size * 2 : 64) - 1;
+
+		for (j = 0; j < size; j++)
+		{
+			if (!utilsTableUsed(table, old + j * table->slotsize))
+				continue;
+			for (i = utilsTableHash(table, old + j * table->slotsize) & table->mask; utilsTableUsed(table, table->slots + i * table->slotsize); i = (i + 1) & table->mask);
+			memcpy(table->slots + i * table->slotsize, old + j * table->slotsize, table->slotsize);
+		}
+		utilsFree(old);
+	}
+
+	for (i = utilsTableHash(table, key) & table->mask; utilsTableUsed(table, slot = table->slots + i * table->slotsize); i = (i + 1) & table->mask);
+	memcpy(slot, key, table->keysize);
+	table->count++;
+
+	return slot;
+}
+
+void *utilsTableNext(HTAB *table, unsigned int *pos)
+{
+	char *slot;
+
+	for (; table->slots != NULL && *pos <= table->mask; (*pos)++)
+		if (utilsTableUsed(table, slot = table->slots + *pos * table->slotsize))
+		{
+			(*pos)++;
+			return slot;
+		}
+
+	return NULL;
+}
+
+void utilsTableRemove(HTAB *table, void *slot)
+{
+	unsigned int i, j, k;
+
+	/* later slots of the same probe run move up, so no tombstones are left */
+	i = ((char *) slot - table->slots) / table->slotsize;
+	for (j = (i + 1) & table->mask; utilsTableUsed(table, table->slots + j * table->slotsize); j = (j + 1) & table->mask)
+	{
+		k = utilsTableHash(table, table->slots + j * table->slotsize) & table->mask;
+		if ((j > i && (k <= i || k > j)) || (j < i && k <= i && k > j))
+		{
+			memcpy(table->slots + i * table->slotsize, table->slots + j * table->slotsize, table->slotsize);
+			i = j;
+		}
+	}
+
+	memset(table->slots + i * table->slotsize, 0, table->slotsize);
+	table->count--;
+}
+
+long utilsGetDents(int fd, void *buf, size_t size)
+{
+	return syscall(SYS_getdents64, fd, buf, size);
+}
+
+/*
+ * Counts the c in the len bytes at buf, sixteen at a time with SSE2.
+ */
+size_t utilsCountByte(const char *buf, size_t len, int c)
+{
+	size_t i = 0;
+	size_t count = 0;
+#ifdef __SSE2__
+	__m128i needle = _mm_set1_epi8(c);
+
+	for (; i + 16 <= len; i += 16)
+		count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (buf + i)), needle)));
+#endif
+	for (; i < len; i++)
+		count += buf[i] == (char) c;
+
+	return count;
+}
+
+/*
+ * Returns the first c in str, or NULL when the end of str comes first.
+ * With SSE2 sixteen bytes are checked at a time, from aligned loads that
+ * never cross into the next page.
+ */
+char *utilsFindByte(const char *str, int c)
+{
+#ifdef __SSE2__
+	__m128i chunk;
+	__m128i needle = _mm_set1_epi8(c);
+	__m128i zero = _mm_setzero_si128();
+	const char *p = (const char *) ((uintptr_t) str & ~(uintptr_t) 15);
+	unsigned int mask;
+
+	chunk = _mm_load_si128((const __m128i *) p);
+	mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, needle), _mm_cmpeq_epi8(chunk, zero)));
+	mask &= ~0u << (str - p);
+
+	while (mask == 0)
+	{
+		p += 16;
+		chunk = _mm_load_si128((const __m128i *) p);
+		mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, needle), _mm_cmpeq_epi8(chunk, zero)));
+	}
+
+	p += __builtin_ctz(mask);
+	return *p == (char) c ? (char *) p : NULL;
+#else
+	return c != '\0' ? strchr(str, c) : NULL;
+#endif
+}
+
+/*
+ * Returns the first str of slen bytes in the len bytes at buf, or NULL.
+ * With SSE2 sixteen places are ruled out at a time by their first and
+ * last byte, only places where both agree are compared in full.
+ */
+char *utilsFindString(const char *buf, size_t len, const char *str, size_t slen)
+{
+#ifdef __SSE2__
+	size_t i;
+	unsigned int mask;
+	__m128i first, last;
 
-	return hashval % HSIZE;
+	if (slen < 2 || len < slen + 15)
+		return memmem(buf, len, str, slen);
+
+	first = _mm_set1_epi8(str[0]);
+	last = _mm_set1_epi8(str[slen - 1]);
+	for (i = 0; i + slen + 15 <= len; i += 16)
+	{
+		mask = _mm_movemask_epi8(_mm_and_si128(
+			_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (buf + i)), first),
+			_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (buf + i + slen - 1)), last)));
+
+		for (; mask != 0; mask &= mask - 1)
+			if (memcmp(buf + i + __builtin_ctz(mask) + 1, str + 1, slen - 2) == 0)
+				return (char *) buf + i + __builtin_ctz(mask);
+	}
+
+	return memmem(buf + i, len - i, str, slen);
+#else
+	return memmem(buf, len, str, slen);
+#endif
+}
+
+/* a bit per character, folded to 32, a name lacking one of the query's cannot match */
+unsigned int utilsFuzzyMask(const char *str)
+{
+	unsigned int mask = 0;
+
+	for (; *str != '\0'; str++)
+		mask |= 1u << (*str & 31);
+
+	return mask;
+}
+
+/*
+ * Scores query as a subsequence of name, both lowercase. Returns -1 when
+ * it is none, else up to 255: a substring beats scattered characters, a
+ * start of the name or of a word beats the middle of one, and among
+ * substrings the shorter name wins.
+ */
+int utilsFuzzyScore(const char *name, const char *query, int qlen)
+{
+	int i, len, score;
+	const char *p, *prev;
+
+	if ((p = strstr(name, query)) != NULL)
+	{
+		score = 128;
+		if (p == name)
+			score += 64;
+		else if (FUZZYSEP(p[-1]))
+			score += 32;
+
+		len = strlen(name) - qlen;
+		return score + (len < 63 ? 63 - len : 0);
+	}
+
+	/* greedy, each character as early as it comes */
+	for (i = score = 0, p = name, prev = NULL; i < qlen; i++, prev = p++)
+	{
+		if ((p = utilsFindByte(p, query[i])) == NULL)
+			return -1;
+
+		if (prev != NULL && p == prev + 1)
+			score += 6;
+		else if (prev != NULL)
+			score -= p - prev - 1 < 3 ? p - prev - 1 : 3;
+
+		if (p == name || FUZZYSEP(p[-1]))
+			score += 4;
+	}
+
+	score += 64;
+	return score < 0 ? 0 : score > 127 ? 127 : score;
+}
+
+/* copies str lowercased, ASCII only so it agrees with the query, returns its length */
+size_t utilsLower(char *dst, const char *str)
+{
+	size_t i = 0;
+	size_t len = strlen(str);
+#ifdef __SSE2__
+	__m128i chunk, upper;
+
+	for (; i + 16 <= len; i += 16)
+	{
+		chunk = _mm_loadu_si128((const __m128i *) (str + i));
+		upper = _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8('Z' + 1)));
+		_mm_storeu_si128((__m128i *) (dst + i), _mm_add_epi8(chunk, _mm_and_si128(upper, _mm_set1_epi8(0x20))));
+	}
+#endif
+	for (; i <= len; i++)
+		dst[i] = (str[i] >= 'A' && str[i] <= 'Z') ? str[i] + 0x20 : str[i];
+
+	return len;
+}
+
+int utilsKeyCMP(unsigned char *key1, int len1, unsigned char *key2, int len2)
+{
+	int cmp;
+
+	if ((cmp = memcmp(key1, key2, len1 < len2 ? len1 : len2)) != 0)
+		return cmp;
+
+	return len1 - len2;
 }
 
 int utilsNameCMP(char *name1, char *name2)
@@ -111,6 +468,52 @@ int utilsNameCMP(char *name1, char *name2)
 	return chr1 - chr2;
 }
 
+/*
+ * Encodes name into a key that memcmp orders exactly like utilsNameCMP:
+ * folded characters (shifted by one, tolower gives EOF for 0xff), every
+ * digit run as its saturated value and how the run ends, then the raw
+ * bytes for the case-sensitive tiebreak.
+ * key must hold KEYSIZE(strlen(name)) bytes. Returns the key length.
+ */
+int utilsNameKey(char *name, unsigned char *key)
+{
+	int i, run;
+	long num;
+	char *str, *end;
+	int len = 0;
+
+	for (str = name; *str != '\0'; str = end)
+	{
+		if (!isdigit(*str))
+		{
+			key[len++] = tolower(*str) + 1;
+			end = str + 1;
+			continue;
+		}
+
+		num = atol(str);
+		for (end = str; isdigit(*end); end++);
+
+		/* runs of equal value compare on by whatever follows the shorter one */
+		run = end - str;
+		if (tolower(*end) >= '0')
+			run = KEYRUN - run;
+
+		key[len++] = '0' + 1;
+		for (i = 56; i >= 0; i -= 8)
+			key[len++] = num >> i;
+		key[len++] = run >> 8;
+		key[len++] = run;
+	}
+	key[len++] = 1;
+
+	for (str = name; *str != '\0'; str++)
+		key[len++] = *str ^ 0x80;
+	key[len++] = 128;
+
+	return len;
+}
+
 void utilsLogBegin(const char *file)
 {
 	time_t curtime;
@@ -1,18 +1,75 @@
 #define FATAL 1
 #define RECOV 0
-#define HSIZE 101
 #define COLOR_DEFAULT -1
 #define LIGHT(COLOR) COLOR + 8
 #define ARRLENGTH(ARRAY) (sizeof ARRAY / sizeof ARRAY[0])
+#define CHUNKMIN (64 * 1024)
+#define CHUNKMAX (8 * 1024 * 1024)
+#define KEYRUN 512
+#define KEYSIZE(LEN) ((LEN) * 12 + 2)
+#define FUZZYSEP(C) ((C) == '.' || (C) == '_' || (C) == '-' || (C) == ' ')
 
 #define utilsFree(ptr) utilsFreeC((void *) &(ptr))
 
+/* linux_dirent64 as returned by getdents64(2) */
+typedef struct dent
+{
+	unsigned long long ino;
+	long long off;
+	unsigned short reclen;
+	unsigned char type;
+	char name[];
+} DENT;
+
+/* bump allocator, everything in it goes away at once */
+typedef struct chnk
+{
+	struct chnk *next;
+	size_t size;
+	size_t used;
+	char data[];
+} CHNK;
+
+typedef struct arna
+{
+	CHNK *chunk;
+	size_t total;
+} ARNA;
+
+/* open addressing over fixed size slots, each starting with its key, an all zero key marks a free slot */
+typedef struct htab
+{
+	char *slots;
+	size_t slotsize;
+	size_t keysize;
+	unsigned int mask;
+	unsigned int count;
+} HTAB;
+
+void *utilsArenaAlloc(ARNA *, size_t);
+void utilsArenaFree(ARNA *);
+char *utilsArenaString(ARNA *, const char *);
 void utilsFreeC(void **);
 void *utilsMalloc(size_t);
 void *utilsCalloc(size_t, size_t);
 void *utilsRealloc(void *, size_t);
-unsigned int utilsCalcHash(char *);
+unsigned int utilsHash(char *);
+void *utilsTableFind(HTAB *, const void *);
+void utilsTableFree(HTAB *);
+void utilsTableInit(HTAB *, size_t, size_t);
+void *utilsTableInsert(HTAB *, const void *);
+void *utilsTableNext(HTAB *, unsigned int *);
+void utilsTableRemove(HTAB *, void *);
+long utilsGetDents(int, void *, size_t);
+size_t utilsCountByte(const char *, size_t, int);
+char *utilsFindByte(const char *, int);
+char *utilsFindString(const char *, size_t, const char *, size_t);
+unsigned int utilsFuzzyMask(const char *);
+int utilsFuzzyScore(const char *, const char *, int);
+size_t utilsLower(char *, const char *);
+int utilsKeyCMP(unsigned char *, int, unsigned char *, int);
 int utilsNameCMP(char *, char *);
+int utilsNameKey(char *, unsigned char *);
 void utilsLogBegin(const char *);
 void utilsLogCommit(int, const char *, ...);
 void utilsLogEnd(void);
\ No newline at end of file